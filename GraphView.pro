@@ -1,4 +1,4 @@
-greaterThan(QT_MAJOR_VERSION, 4):QT += widgets webkitwidgets
+greaterThan(QT_MAJOR_VERSION, 4):QT += widgets webkitwidgets concurrent network
 
 # Add more folders to ship with the application, here
 folder_01.source = html
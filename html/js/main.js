@@ -44,24 +44,35 @@ $(function() {
     spacingTop:1
   },
   xAxis:{
+    ordinal:false,
+    events:{
+      afterSetExtremes:function(e){
+        if(window.Qt)
+          Qt.setExtremes(e.min, e.max);
+      }
+    },
     labels:{
       formatter:function(){
         return this.value;
       }
     }
   },
+  //значения под курсором ищет приложение (setCrosshair), библиотека точки рядов не перебирает
+  plotOptions:{
+    series:{
+      enableMouseTracking:false
+    },
+    flags:{
+      enableMouseTracking:true
+    }
+  },
   tooltip: {
     formatter: function() {
-      var s = '<b>'+ Highcharts.dateFormat('%L', this.x) +'</b>';
-
-      $.each(this.points, function(i, point) {
-        s += '<br/>'+point.series.name+': '+ point.y;
-      });
-
-      return s;
+      return this.point && this.point.text ? this.point.text : false;
     }
   },
   navigator:{xAxis:{
+   ordinal:false,
    labels:{
      formatter:function(){
        return this.value;
@@ -73,4 +84,113 @@ $(function() {
   enabled:false
 }
 });
+  $('#container').off('mousemove.crosshair').on('mousemove.crosshair',function(e){
+    var chart=$('#container').highcharts();
+    if(!chart || !window.Qt)
+      return;
+    var x=e.pageX-$('#container').offset().left;
+    if(x>=chart.plotLeft && x<=chart.plotLeft+chart.plotWidth)
+      Qt.setHoverTime(chart.xAxis[0].toValue(x));
+  });
 });
+
+function setCrosshair(t,text){
+  var chart=$('#container').highcharts();
+  if(!chart)
+    return;
+  chart.xAxis[0].removePlotLine('crosshair');
+  chart.xAxis[0].addPlotLine({id:'crosshair',value:t,color:'#888',width:1,zIndex:4});
+  if(chart.crosshairLabel)
+    chart.crosshairLabel.destroy();
+  chart.crosshairLabel=chart.renderer.label(text,chart.plotLeft+5,chart.plotTop+5)
+    .attr({fill:'rgba(255,255,255,0.85)',stroke:'#888','stroke-width':1,padding:4,zIndex:6})
+    .add();
+}
+
+function setCursor(t){
+  var chart=$('#container').highcharts();
+  if(!chart)
+    return;
+  chart.xAxis[0].removePlotLine('cursor');
+  chart.xAxis[0].addPlotLine({id:'cursor',value:t,color:'#c00',width:1,zIndex:5});
+}
+
+function setWindow(min,max){
+  var chart=$('#container').highcharts();
+  if(chart)
+    chart.xAxis[0].setExtremes(min,max);
+}
+
+//пока график не построен, данные подменяются в DATA, из которого он будет создан
+function setSeriesData(name,data){
+  var chart=$('#container').highcharts();
+  if(!chart){
+    $.each(DATA,function(i,series){
+      if(series.name==name)
+        series.data=data;
+    });
+    return;
+  }
+  $.each(chart.series,function(i,series){
+    if(series.name==name)
+      series.setData(data,true);
+  });
+}
+
+//новые отсчёты живого прогона дописываются в конец ряда, одна перерисовка на пачку
+function appendSeriesData(name,data){
+  var chart=$('#container').highcharts();
+  if(!chart){
+    $.each(DATA,function(i,series){
+      if(series.name==name)
+        series.data=series.data.concat(data);
+    });
+    return;
+  }
+  $.each(chart.series,function(i,series){
+    if(series.name==name)
+      $.each(data,function(j,point){
+        series.addPoint(point,false);
+      });
+  });
+  chart.redraw();
+}
+
+//отдельный прогон поверх сводки процентилей; пустые данные - убрать
+function setRunOverlay(id,name,color,data){
+  var chart=$('#container').highcharts();
+  if(!chart)
+    return;
+  var series=chart.get(id);
+  if(series)
+    series.remove(false);
+  if(data.length)
+    chart.addSeries({id:id,name:name,color:color,data:data,type:'spline'},false);
+  chart.redraw();
+}
+
+function setEventFlags(name,data){
+  var flags=name+' events';
+  var chart=$('#container').highcharts();
+  var list=chart ? chart.series : DATA;
+  var color;
+  var found=false;
+  $.each(list,function(i,series){
+    if(series.name==name)
+      color=series.color;
+    if(series.name==flags){
+      found=true;
+      if(chart)
+        series.setData(data,true);
+      else
+        series.data=data;
+    }
+  });
+  if(found || !data.length)
+    return;
+  var options={type:'flags',name:flags,color:color,shape:'squarepin',data:data};
+  if(chart)
+    chart.addSeries(options);
+  else
+    DATA.push(options);
+}
@@ -0,0 +1,317 @@
+#include "channelexpression.h"
+#include "graphdata.h"
+#include <qnumeric.h>
+#include <algorithm>
+#include <cmath>
+
+static const char *KChannelNames[GraphData::ChannelCount]={"current_wheel_angle","desired_wheel_angle","wheel_power_r","wheel_power_l","physics_timestep","control_interval","line_position","tracking_error"};
+
+ChannelExpression::ChannelExpression()
+    : m_pos(0)
+{
+
+}
+
+bool ChannelExpression::compile(const QString &text)
+{
+    m_text=text;
+    m_error.clear();
+    m_plan.clear();
+    m_pos=0;
+    if(parseExpression()<0)
+    {
+        m_plan.clear();
+        return false;
+    }
+    skipSpaces();
+    if(m_pos<m_text.length())
+    {
+        fail("Unexpected '"+QString(m_text[m_pos])+"'");
+        m_plan.clear();
+        return false;
+    }
+    return true;
+}
+
+int ChannelExpression::push(Op op, int a, int b, float value)
+{
+    Instruction instruction;
+    instruction.op=op;
+    instruction.a=a;
+    instruction.b=b;
+    instruction.value=value;
+    instruction.lookback=0;
+    if(op!=LoadChannel && a>=0)
+        instruction.lookback=m_plan[a].lookback;
+    if(b>=0)
+        instruction.lookback=qMax(instruction.lookback,m_plan[b].lookback);
+    if(op==MovingAverage)
+        instruction.lookback+=int(value)-1;
+    m_plan.append(instruction);
+    return m_plan.size()-1;
+}
+
+int ChannelExpression::fail(const QString &error)
+{
+    if(m_error.isEmpty())
+        m_error=error+" at position "+QString::number(m_pos+1);
+    return -1;
+}
+
+void ChannelExpression::skipSpaces()
+{
+    while(m_pos<m_text.length() && m_text[m_pos].isSpace())
+        m_pos++;
+}
+
+bool ChannelExpression::accept(QChar c)
+{
+    skipSpaces();
+    if(m_pos<m_text.length() && m_text[m_pos]==c)
+    {
+        m_pos++;
+        return true;
+    }
+    return false;
+}
+
+QString ChannelExpression::parseIdentifier()
+{
+    int start=m_pos;
+    while(m_pos<m_text.length() && (m_text[m_pos].isLetterOrNumber() || m_text[m_pos]==QChar('_')))
+        m_pos++;
+    return m_text.mid(start,m_pos-start);
+}
+
+int ChannelExpression::parseExpression()
+{
+    int left=parseTerm();
+    while(left>=0)
+    {
+        if(accept('+'))
+        {
+            int right=parseTerm();
+            left=right<0 ? -1 : push(Add,left,right);
+        }
+        else if(accept('-'))
+        {
+            int right=parseTerm();
+            left=right<0 ? -1 : push(Sub,left,right);
+        }
+        else
+            break;
+    }
+    return left;
+}
+
+int ChannelExpression::parseTerm()
+{
+    int left=parseUnary();
+    while(left>=0)
+    {
+        if(accept('*'))
+        {
+            int right=parseUnary();
+            left=right<0 ? -1 : push(Mul,left,right);
+        }
+        else if(accept('/'))
+        {
+            int right=parseUnary();
+            left=right<0 ? -1 : push(Div,left,right);
+        }
+        else
+            break;
+    }
+    return left;
+}
+
+int ChannelExpression::parseUnary()
+{
+    if(accept('-'))
+    {
+        int operand=parseUnary();
+        return operand<0 ? -1 : push(Neg,operand);
+    }
+    return parsePrimary();
+}
+
+int ChannelExpression::parsePrimary()
+{
+    skipSpaces();
+    if(m_pos>=m_text.length())
+        return fail("Unexpected end of expression");
+    if(accept('('))
+    {
+        int inner=parseExpression();
+        if(inner>=0 && !accept(')'))
+            return fail("Expected ')'");
+        return inner;
+    }
+    QChar c=m_text[m_pos];
+    if(c.isDigit() || c==QChar('.'))
+    {
+        int start=m_pos;
+        while(m_pos<m_text.length() && (m_text[m_pos].isDigit() || m_text[m_pos]==QChar('.')))
+            m_pos++;
+        if(m_pos<m_text.length() && (m_text[m_pos]==QChar('e') || m_text[m_pos]==QChar('E')))
+        {
+            m_pos++;
+            if(m_pos<m_text.length() && (m_text[m_pos]==QChar('+') || m_text[m_pos]==QChar('-')))
+                m_pos++;
+            while(m_pos<m_text.length() && m_text[m_pos].isDigit())
+                m_pos++;
+        }
+        bool ok;
+        double value=m_text.mid(start,m_pos-start).toDouble(&ok);
+        if(!ok)
+            return fail("Bad number");
+        return push(Constant,-1,-1,value);
+    }
+    if(!c.isLetter() && c!=QChar('_'))
+        return fail("Unexpected '"+QString(c)+"'");
+    QString name=parseIdentifier();
+    if(accept('('))
+        return parseCall(name);
+    if(name=="t")
+        return push(LoadTime);
+    for(int i=0;i<GraphData::ChannelCount;i++)
+        if(name==KChannelNames[i])
+            return push(LoadChannel,i);
+    return fail("Unknown channel '"+name+"'");
+}
+
+int ChannelExpression::parseCall(const QString &name)
+{
+    if(name!="abs" && name!="sqrt" && name!="ma" && name!="min" && name!="max")
+        return fail("Unknown function '"+name+"'");
+    int a=parseExpression();
+    if(a<0)
+        return -1;
+    if(name=="abs" || name=="sqrt")
+    {
+        if(!accept(')'))
+            return fail("Expected ')'");
+        return push(name=="abs" ? Abs : Sqrt,a);
+    }
+    if(!accept(','))
+        return fail("Expected ','");
+    if(name=="ma")
+    {
+        //окно скользящего среднего должно быть известно при компиляции
+        skipSpaces();
+        int start=m_pos;
+        while(m_pos<m_text.length() && m_text[m_pos].isDigit())
+            m_pos++;
+        int window=m_text.mid(start,m_pos-start).toInt();
+        if(window<1)
+            return fail("Window must be a positive integer");
+        if(!accept(')'))
+            return fail("Expected ')'");
+        return push(MovingAverage,a,-1,window);
+    }
+    int b=parseExpression();
+    if(b<0)
+        return -1;
+    if(!accept(')'))
+        return fail("Expected ')'");
+    return push(name=="min" ? Min : Max,a,b);
+}
+
+QVector<float> ChannelExpression::evaluate(const GraphData &data, int index, int begin, int end) const
+{
+    const int size=data.time(index).size();
+    end=qMin(end,size);
+    begin=qBound(0,begin,end);
+    const int first=qMax(0,begin-lookback());
+    const int n=end-first;
+    QVector<QVector<float> > registers(m_plan.size());
+    for(int k=0;k<m_plan.size();k++)
+    {
+        const Instruction &ins=m_plan[k];
+        QVector<float> &r=registers[k];
+        r.resize(n);
+        float *d=r.data();
+        const float *a=(ins.op!=LoadChannel && ins.a>=0) ? registers[ins.a].constData() : 0;
+        const float *b=ins.b>=0 ? registers[ins.b].constData() : 0;
+        switch(ins.op)
+        {
+        case LoadChannel:
+        {
+            const float *src=data.column(index,ins.a).constData()+first;
+            std::copy(src,src+n,d);
+            break;
+        }
+        case LoadTime:
+        {
+            const double *src=data.time(index).constData()+first;
+            for(int i=0;i<n;i++)
+                d[i]=float(src[i]);
+            break;
+        }
+        case Constant:
+            std::fill(d,d+n,ins.value);
+            break;
+        case Add:
+            for(int i=0;i<n;i++)
+                d[i]=a[i]+b[i];
+            break;
+        case Sub:
+            for(int i=0;i<n;i++)
+                d[i]=a[i]-b[i];
+            break;
+        case Mul:
+            for(int i=0;i<n;i++)
+                d[i]=a[i]*b[i];
+            break;
+        case Div:
+            for(int i=0;i<n;i++)
+                d[i]=a[i]/b[i];
+            break;
+        case Neg:
+            for(int i=0;i<n;i++)
+                d[i]=-a[i];
+            break;
+        case Abs:
+            for(int i=0;i<n;i++)
+                d[i]=std::fabs(a[i]);
+            break;
+        case Sqrt:
+            for(int i=0;i<n;i++)
+                d[i]=std::sqrt(a[i]);
+            break;
+        case Min:
+            for(int i=0;i<n;i++)
+                d[i]=std::min(a[i],b[i]);
+            break;
+        case Max:
+            for(int i=0;i<n;i++)
+                d[i]=std::max(a[i],b[i]);
+            break;
+        case MovingAverage:
+        {
+            //NaN/inf в окне пропускаются, чтобы не портить всю оставшуюся сумму
+            const int window=int(ins.value);
+            double sum=0;
+            int count=0;
+            for(int i=0;i<n;i++)
+            {
+                if(qIsFinite(a[i]))
+                {
+                    sum+=a[i];
+                    count++;
+                }
+                if(i>=window && qIsFinite(a[i-window]))
+                {
+                    sum-=a[i-window];
+                    count--;
+                }
+                d[i]=count ? float(sum/count) : float(qQNaN());
+            }
+            break;
+        }
+        }
+    }
+    if(m_plan.isEmpty())
+        return QVector<float>(end-begin,float(qQNaN()));
+    return registers.last().mid(begin-first);
+}
@@ -0,0 +1,52 @@
+#ifndef CHANNELEXPRESSION_H
+#define CHANNELEXPRESSION_H
+
+#include <QString>
+#include <QVector>
+
+class GraphData;
+
+//Производный канал, например "wheel_power_r - wheel_power_l" или "ma(current_wheel_angle, 20)".
+//Выражение компилируется один раз в план операций над целыми массивами,
+//вычисление идёт только по запрошенному диапазону отсчётов
+class ChannelExpression
+{
+public:
+    ChannelExpression();
+
+    bool compile(const QString &text);
+    QString text() const {return m_text;}
+    QString errorString() const {return m_error;}
+    int lookback() const {return m_plan.isEmpty() ? 0 : m_plan.last().lookback;}
+
+    QVector<float> evaluate(const GraphData &data,int index,int begin,int end) const;
+
+private:
+    enum Op{LoadChannel,LoadTime,Constant,Add,Sub,Mul,Div,Neg,Abs,Sqrt,Min,Max,MovingAverage};
+    struct Instruction
+    {
+        Op op;
+        int a;
+        int b;
+        float value;
+        int lookback;//сколько предыдущих отсчётов нужно для вычисления
+    };
+
+    QVector<Instruction> m_plan;
+    QString m_text;
+    QString m_error;
+    int m_pos;
+
+    int push(Op op,int a=-1,int b=-1,float value=0);
+    int fail(const QString &error);
+    void skipSpaces();
+    bool accept(QChar c);
+    QString parseIdentifier();
+    int parseExpression();
+    int parseTerm();
+    int parseUnary();
+    int parsePrimary();
+    int parseCall(const QString &name);
+};
+
+#endif // CHANNELEXPRESSION_H
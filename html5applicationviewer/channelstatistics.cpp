@@ -0,0 +1,116 @@
+#include "channelstatistics.h"
+#include <qnumeric.h>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+static const int KPercentileSamples = 2048;
+
+ChannelStatistics::ChannelStatistics()
+    : m_size(0)
+{
+
+}
+
+void ChannelStatistics::merge(Moments &a, const Moments &b)
+{
+    if(b.count==0)
+        return;
+    const int count=a.count+b.count;
+    const double delta=b.mean-a.mean;
+    a.mean+=delta*b.count/count;
+    a.m2+=b.m2+delta*delta*double(a.count)*b.count/count;
+    a.count=count;
+}
+
+void ChannelStatistics::build(const QVector<float> &column)
+{
+    const int n=column.size();
+    const float *v=column.constData();
+    const float inf=std::numeric_limits<float>::infinity();
+    m_size=n;
+    m_moments.resize(2*n);
+    m_minTree.resize(2*n);
+    m_maxTree.resize(2*n);
+    for(int i=0;i<n;i++)
+    {
+        const bool finite=qIsFinite(v[i]);
+        Moments leaf={finite,finite ? v[i] : 0.0,0.0};
+        m_moments[n+i]=leaf;
+        m_minTree[n+i]=finite ? v[i] : inf;
+        m_maxTree[n+i]=finite ? v[i] : -inf;
+    }
+    //без ветвлений, чтобы компилятор мог векторизовать
+    for(int i=n-1;i>0;i--)
+    {
+        m_minTree[i]=std::min(m_minTree[2*i],m_minTree[2*i+1]);
+        m_maxTree[i]=std::max(m_maxTree[2*i],m_maxTree[2*i+1]);
+    }
+    for(int i=n-1;i>0;i--)
+    {
+        m_moments[i]=m_moments[2*i];
+        merge(m_moments[i],m_moments[2*i+1]);
+    }
+}
+
+ChannelStatistics::Result ChannelStatistics::query(const QVector<float> &column, int begin, int end) const
+{
+    Result r;
+    const float nan=std::numeric_limits<float>::quiet_NaN();
+    begin=qBound(0,begin,m_size);
+    end=qBound(begin,end,m_size);
+    r.min=r.max=r.p5=r.p25=r.p50=r.p75=r.p95=nan;
+    r.mean=r.stddev=r.rms=nan;
+
+    Moments moments={0,0.0,0.0};
+    float mn=std::numeric_limits<float>::infinity();
+    float mx=-mn;
+    for(int l=begin+m_size,h=end+m_size;l<h;l>>=1,h>>=1)
+    {
+        if(l&1)
+        {
+            merge(moments,m_moments[l]);
+            mn=std::min(mn,m_minTree[l]);
+            mx=std::max(mx,m_maxTree[l]);
+            l++;
+        }
+        if(h&1)
+        {
+            h--;
+            merge(moments,m_moments[h]);
+            mn=std::min(mn,m_minTree[h]);
+            mx=std::max(mx,m_maxTree[h]);
+        }
+    }
+    r.count=moments.count;
+    if(r.count==0)
+        return r;
+    r.mean=moments.mean;
+    r.stddev=std::sqrt(moments.m2/r.count);
+    r.rms=std::sqrt(moments.m2/r.count+r.mean*r.mean);
+    r.min=mn;
+    r.max=mx;
+
+    //перцентили оцениваются по равномерной выборке из диапазона
+    const int step=std::max(1,(end-begin)/KPercentileSamples);
+    QVector<float> sample;
+    sample.reserve((end-begin)/step+1);
+    for(int i=begin;i<end;i+=step)
+        if(qIsFinite(column[i]))
+            sample.append(column[i]);
+    if(sample.isEmpty())
+        return r;
+    float *first=sample.data();
+    float *last=first+sample.size();
+    const double quantiles[5]={0.05,0.25,0.5,0.75,0.95};
+    float *results[5]={&r.p5,&r.p25,&r.p50,&r.p75,&r.p95};
+    float *from=first;
+    for(int i=0;i<5;i++)
+    {
+        float *nth=first+int(quantiles[i]*(sample.size()-1));
+        std::nth_element(from,nth,last);
+        *results[i]=*nth;
+        from=nth;
+    }
+    return r;
+}
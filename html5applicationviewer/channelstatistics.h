@@ -0,0 +1,48 @@
+#ifndef CHANNELSTATISTICS_H
+#define CHANNELSTATISTICS_H
+
+#include <QVector>
+
+//Индекс по одному каналу для запросов статистики на отрезке [begin,end) за O(log n):
+//в узлах дерева отрезков min/max и число, среднее и M2 значений, которые сливаются по формуле
+//Чана - разность сумм квадратов теряет точность, когда разброс мал по сравнению со средним
+class ChannelStatistics
+{
+public:
+    struct Result
+    {
+        int count;
+        float min;
+        float max;
+        double mean;
+        double stddev;
+        double rms;
+        float p5;
+        float p25;
+        float p50;
+        float p75;
+        float p95;
+    };
+
+    ChannelStatistics();
+
+    void build(const QVector<float> &column);
+    int size() const {return m_size;}
+    Result query(const QVector<float> &column,int begin,int end) const;
+
+private:
+    struct Moments
+    {
+        int count;
+        double mean;
+        double m2;//сумма квадратов отклонений от mean
+    };
+    static void merge(Moments &a,const Moments &b);
+
+    int m_size;
+    QVector<Moments> m_moments;
+    QVector<float> m_minTree;
+    QVector<float> m_maxTree;
+};
+
+#endif // CHANNELSTATISTICS_H
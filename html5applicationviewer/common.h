@@ -6,7 +6,7 @@
 #include <QDebug>
 
 constexpr int CAMERA_FRAME_LEN = 128;
-constexpr quint32 DATASET_VERSION=0x1;
+constexpr quint32 DATASET_VERSION=0x2;
 
 typedef struct
 {
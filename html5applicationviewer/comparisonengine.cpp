@@ -0,0 +1,207 @@
+#include "comparisonengine.h"
+#include <QtConcurrentMap>
+#include <qnumeric.h>
+#include <cmath>
+
+#include "taskscheduler.h"
+#include "resample.h"
+
+namespace
+{
+//копии общие с GraphData до первого изменения: задача не зависит от дальнейшей загрузки
+struct CompareJob
+{
+    QVector<double> referenceTime;
+    QVector<float> reference;
+    QVector<double> runTime;
+    QVector<float> run;
+    const TaskScheduler::Token *token;
+};
+
+struct CompareFunctor
+{
+    typedef ComparisonEngine::Result result_type;
+
+    ComparisonEngine::Result operator()(const CompareJob &job)
+    {
+        ComparisonEngine::Result r;
+        r.referenceSize=job.reference.size();
+        r.runSize=job.run.size();
+        r.scores.count=0;
+        if(job.token->isCancelled())
+            return r;
+        QVector<float> resampled=resample(job.runTime,job.run,job.referenceTime);
+        const int n=resampled.size();
+        r.difference.resize(n);
+        r.absError.resize(n);
+        double sumSq=0;
+        double sumAbs=0;
+        double maxAbs=0;
+        int count=0;
+        for(int i=0;i<n;i++)
+        {
+            float d=resampled[i]-job.reference[i];
+            r.difference[i]=d;
+            r.absError[i]=std::fabs(d);
+            if(qIsFinite(d))
+            {
+                sumSq+=double(d)*d;
+                sumAbs+=std::fabs(d);
+                maxAbs=qMax(maxAbs,double(std::fabs(d)));
+                count++;
+            }
+        }
+        r.scores.count=count;
+        r.scores.rmse=count ? std::sqrt(sumSq/count) : qQNaN();
+        r.scores.meanAbsError=count ? sumAbs/count : qQNaN();
+        r.scores.maxAbsError=count ? maxAbs : qQNaN();
+        return r;
+    }
+};
+
+//пары считаются параллельно внутри одной задачи планировщика
+struct CompareTask
+{
+    typedef QList<ComparisonEngine::Result> result_type;
+    QList<CompareJob> jobs;
+    result_type operator()(const TaskScheduler::Token &token) const
+    {
+        QList<CompareJob> list=jobs;
+        for(int i=0;i<list.size();i++)
+            list[i].token=&token;
+        return QtConcurrent::blockingMapped(list,CompareFunctor());
+    }
+};
+}
+
+ComparisonEngine::ComparisonEngine(GraphData &data, QObject *parent)
+    : QObject(parent)
+    , m_data(data)
+{
+
+}
+
+void ComparisonEngine::setReference(const QString &name)
+{
+    if(name==m_reference)
+        return;
+    m_reference=name;
+    m_cache.clear();
+    QList<Watcher*> pending=m_pending.keys();
+    for(int i=0;i<pending.size();i++)
+        discard(pending[i]);
+}
+
+bool ComparisonEngine::isActive()
+{
+    return !m_reference.isEmpty() && m_data.findByName(m_reference)!=-1;
+}
+
+bool ComparisonEngine::isCurrent(const Key &key)
+{
+    if(!m_cache.contains(key))
+        return false;
+    const Result &r=m_cache[key];
+    int ref=m_data.findByName(m_reference);
+    int run=m_data.findByName(key.first);
+    return r.referenceSize==m_data.column(ref,key.second).size() && r.runSize==m_data.column(run,key.second).size();
+}
+
+void ComparisonEngine::compute(const QList<int> &channels)
+{
+    if(!isActive())
+        return;
+    int ref=m_data.findByName(m_reference);
+    QList<Key> keys;
+    QList<CompareJob> jobs;
+    for(int i=0;i<m_data.length();i++)
+    {
+        if(i==ref)
+            continue;
+        for(int j=0;j<channels.length();j++)
+        {
+            Key key(m_data.get_name(i),channels[j]);
+            if(isCurrent(key) || m_pendingKeys.contains(key))
+                continue;
+            //столбцы берутся здесь: производные каналы вычисляются только в потоке интерфейса
+            CompareJob job;
+            job.referenceTime=m_data.time(ref);
+            job.reference=m_data.column(ref,channels[j]);
+            job.runTime=m_data.time(i);
+            job.run=m_data.column(i,channels[j]);
+            job.token=0;
+            keys<<key;
+            jobs<<job;
+        }
+    }
+    if(keys.isEmpty())
+        return;
+    //результаты кэшируются до смены опорного прогона; сравнение на экране, поэтому раньше упреждающей работы
+    CompareTask task;
+    task.jobs=jobs;
+    Watcher *watcher=new Watcher(this);
+    connect(watcher,SIGNAL(finished()),SLOT(computed()));
+    m_pending.insert(watcher,keys);
+    for(int i=0;i<keys.size();i++)
+        m_pendingKeys.insert(keys[i]);
+    watcher->setFuture(TaskScheduler::run(TaskScheduler::VisibleRuns,task));
+}
+
+void ComparisonEngine::computed()
+{
+    Watcher *watcher=static_cast<Watcher*>(sender());
+    watcher->deleteLater();
+    if(!m_pending.contains(watcher))
+        return;
+    QList<Key> keys=m_pending.take(watcher);
+    for(int i=0;i<keys.size();i++)
+        m_pendingKeys.remove(keys[i]);
+    if(watcher->isCanceled())
+        return;
+    QList<Result> results=watcher->result();
+    for(int i=0;i<keys.size() && i<results.size();i++)
+        m_cache.insert(keys[i],results[i]);
+    emit changed();
+}
+
+void ComparisonEngine::discard(Watcher *watcher)
+{
+    //ещё не начатая задача не запустится, результат идущей не будет принят
+    QList<Key> keys=m_pending.take(watcher);
+    for(int i=0;i<keys.size();i++)
+        m_pendingKeys.remove(keys[i]);
+    watcher->cancel();
+    disconnect(watcher,0,this,0);
+    connect(watcher,SIGNAL(finished()),watcher,SLOT(deleteLater()));
+}
+
+const ComparisonEngine::Result *ComparisonEngine::result(const QString &run, int channel)
+{
+    Key key(run,channel);
+    return isCurrent(key) ? &m_cache[key] : 0;
+}
+
+void ComparisonEngine::invalidate(const QString &run)
+{
+    if(run==m_reference)
+    {
+        m_cache.clear();
+        QList<Watcher*> pending=m_pending.keys();
+        for(int i=0;i<pending.size();i++)
+            discard(pending[i]);
+        return;
+    }
+    for(int i=0;i<m_data.channelCount();i++)
+        m_cache.remove(Key(run,i));
+    QList<Watcher*> pending=m_pending.keys();
+    for(int i=0;i<pending.size();i++)
+    {
+        const QList<Key> &keys=m_pending[pending[i]];
+        for(int k=0;k<keys.size();k++)
+            if(keys[k].first==run)
+            {
+                discard(pending[i]);
+                break;
+            }
+    }
+}
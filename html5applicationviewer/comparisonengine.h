@@ -0,0 +1,67 @@
+#ifndef COMPARISONENGINE_H
+#define COMPARISONENGINE_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QPair>
+#include <QVector>
+#include <QFutureWatcher>
+
+#include "graphdata.h"
+
+//Сравнение прогонов с опорным: каналы пересчитываются на шкалу времени опорного прогона.
+//Считается в фоне; готовые результаты кэшируются, о новых сообщает changed()
+class ComparisonEngine : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode{Difference,AbsoluteError};
+
+    struct Scores
+    {
+        int count;
+        double rmse;
+        double meanAbsError;
+        double maxAbsError;
+    };
+
+    struct Result
+    {
+        int referenceSize;
+        int runSize;
+        QVector<float> difference;
+        QVector<float> absError;
+        Scores scores;
+    };
+
+    explicit ComparisonEngine(GraphData &data,QObject *parent = 0);
+
+    void setReference(const QString &name);
+    QString reference() const {return m_reference;}
+    bool isActive();
+
+    void compute(const QList<int> &channels);//недостающие и устаревшие пары прогон-канал
+    const Result *result(const QString &run,int channel);//0 - ещё считается
+    void invalidate(const QString &run);
+
+signals:
+    void changed();
+
+private slots:
+    void computed();
+
+private:
+    typedef QPair<QString,int> Key;
+    typedef QFutureWatcher<QList<Result> > Watcher;
+    GraphData &m_data;
+    QString m_reference;
+    QHash<Key,Result> m_cache;
+    QHash<Watcher*,QList<Key> > m_pending;
+    QSet<Key> m_pendingKeys;
+    bool isCurrent(const Key &key);
+    void discard(Watcher *watcher);
+};
+
+#endif // COMPARISONENGINE_H
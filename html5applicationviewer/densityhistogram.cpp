@@ -0,0 +1,227 @@
+#include "densityhistogram.h"
+#include <QThread>
+#include <QtConcurrentMap>
+#include <qnumeric.h>
+
+static const int KCancelCheck = 1<<20;//точек между проверками отмены
+
+namespace
+{
+struct Segment
+{
+    const DensityHistogram::Series *series;
+    int begin;
+    int end;
+};
+
+struct Part
+{
+    QVector<Segment> segments;
+    const TaskScheduler::Token *token;
+    double xMin;
+    double yMin;
+    double xScale;//столбцов на единицу x
+    double yScale;
+    int columns;
+    int rows;
+};
+
+struct Extent
+{
+    double xMin;
+    double xMax;
+    double yMin;
+    double yMax;
+    qint64 total;
+    Extent() : xMin(qInf()), xMax(-qInf()), yMin(qInf()), yMax(-qInf()), total(0) {}
+};
+
+struct Bins
+{
+    QVector<quint32> counts;
+    qint64 count;
+    Bins() : count(0) {}
+};
+
+struct ExtentFunctor
+{
+    typedef Extent result_type;
+
+    Extent operator()(const Part &part)
+    {
+        Extent e;
+        for(int s=0;s<part.segments.size();s++)
+        {
+            const float *x=part.segments[s].series->x.constData();
+            const float *y=part.segments[s].series->y.constData();
+            for(int i=part.segments[s].begin;i<part.segments[s].end;i++)
+            {
+                if(!qIsFinite(x[i]) || !qIsFinite(y[i]))
+                    continue;
+                e.xMin=qMin(e.xMin,double(x[i]));
+                e.xMax=qMax(e.xMax,double(x[i]));
+                e.yMin=qMin(e.yMin,double(y[i]));
+                e.yMax=qMax(e.yMax,double(y[i]));
+                e.total++;
+            }
+        }
+        return e;
+    }
+};
+
+struct BinFunctor
+{
+    typedef Bins result_type;
+
+    Bins operator()(const Part &part)
+    {
+        Bins b;
+        b.counts.fill(0,part.columns*part.rows);
+        quint32 *counts=b.counts.data();
+        int sinceCheck=0;
+        for(int s=0;s<part.segments.size();s++)
+        {
+            const float *x=part.segments[s].series->x.constData();
+            const float *y=part.segments[s].series->y.constData();
+            for(int i=part.segments[s].begin;i<part.segments[s].end;i++)
+            {
+                //NaN не проходит ни одно сравнение и отбрасывается вместе с точками вне области
+                const double cx=(x[i]-part.xMin)*part.xScale;
+                const double cy=(y[i]-part.yMin)*part.yScale;
+                if(!(cx>=0 && cx<part.columns && cy>=0 && cy<part.rows))
+                    continue;
+                counts[int(cy)*part.columns+int(cx)]++;
+                b.count++;
+            }
+            sinceCheck+=part.segments[s].end-part.segments[s].begin;
+            if(sinceCheck>=KCancelCheck)
+            {
+                sinceCheck=0;
+                if(part.token->isCancelled())
+                    break;
+            }
+        }
+        return b;
+    }
+};
+
+void mergeExtent(Extent &total,const Extent &part)
+{
+    total.xMin=qMin(total.xMin,part.xMin);
+    total.xMax=qMax(total.xMax,part.xMax);
+    total.yMin=qMin(total.yMin,part.yMin);
+    total.yMax=qMax(total.yMax,part.yMax);
+    total.total+=part.total;
+}
+
+void mergeBins(Bins &total,const Bins &part)
+{
+    total.count+=part.count;
+    if(total.counts.isEmpty())
+    {
+        total.counts=part.counts;
+        return;
+    }
+    quint32 *counts=total.counts.data();
+    for(int i=0;i<part.counts.size();i++)
+        counts[i]+=part.counts[i];
+}
+
+//точки всех прогонов поровну на каждый поток, куски не длиннее KCancelCheck
+QList<Part> split(const QVector<DensityHistogram::Series> &series,const TaskScheduler::Token &token)
+{
+    qint64 points=0;
+    for(int i=0;i<series.size();i++)
+        points+=qMin(series[i].x.size(),series[i].y.size());
+    const int threads=qMax(1,QThread::idealThreadCount());
+    const qint64 perPart=qMax<qint64>(1,(points+threads-1)/threads);
+    QList<Part> parts;
+    Part part;
+    part.token=&token;
+    qint64 filled=0;
+    for(int i=0;i<series.size();i++)
+    {
+        const int size=qMin(series[i].x.size(),series[i].y.size());
+        for(int begin=0;begin<size;)
+        {
+            Segment segment;
+            segment.series=&series[i];
+            segment.begin=begin;
+            segment.end=int(qMin<qint64>(size,begin+qMin<qint64>(KCancelCheck,perPart-filled)));
+            part.segments<<segment;
+            filled+=segment.end-begin;
+            begin=segment.end;
+            if(filled==perPart)
+            {
+                parts<<part;
+                part.segments.clear();
+                filled=0;
+            }
+        }
+    }
+    if(!part.segments.isEmpty())
+        parts<<part;
+    return parts;
+}
+}
+
+DensityHistogram::Result DensityHistogram::compute(const QVector<Series> &series, double xMin, double xMax, double yMin, double yMax,
+                                                   int columns, int rows, const TaskScheduler::Token &token)
+{
+    Result r;
+    r.columns=columns;
+    r.rows=rows;
+    r.maxCount=0;
+    r.count=0;
+    QList<Part> parts=split(series,token);
+    Extent extent=QtConcurrent::blockingMappedReduced(parts,ExtentFunctor(),mergeExtent);
+    r.total=extent.total;
+    if(!(xMin<xMax))
+    {
+        xMin=extent.xMin;
+        xMax=extent.xMax;
+    }
+    if(!(yMin<yMax))
+    {
+        yMin=extent.yMin;
+        yMax=extent.yMax;
+    }
+    //постоянный канал растягивается на единичный отрезок вокруг значения
+    if(xMin==xMax)
+    {
+        xMin-=0.5;
+        xMax+=0.5;
+    }
+    if(yMin==yMax)
+    {
+        yMin-=0.5;
+        yMax+=0.5;
+    }
+    r.xMin=xMin;
+    r.xMax=xMax;
+    r.yMin=yMin;
+    r.yMax=yMax;
+    if(extent.total==0 || !qIsFinite(xMax-xMin) || !qIsFinite(yMax-yMin) || token.isCancelled())
+    {
+        r.bins.fill(0,columns*rows);
+        return r;
+    }
+    for(int i=0;i<parts.size();i++)
+    {
+        parts[i].xMin=xMin;
+        parts[i].yMin=yMin;
+        //правая и верхняя границы попадают в последний столбец и строку
+        parts[i].xScale=columns/(xMax-xMin)*(1-1e-9);
+        parts[i].yScale=rows/(yMax-yMin)*(1-1e-9);
+        parts[i].columns=columns;
+        parts[i].rows=rows;
+    }
+    Bins bins=QtConcurrent::blockingMappedReduced(parts,BinFunctor(),mergeBins);
+    r.bins=bins.counts;
+    r.count=bins.count;
+    if(r.bins.isEmpty())
+        r.bins.fill(0,columns*rows);
+    for(int i=0;i<r.bins.size();i++)
+        r.maxCount=qMax(r.maxCount,r.bins[i]);
+    return r;
+}
@@ -0,0 +1,39 @@
+#ifndef DENSITYHISTOGRAM_H
+#define DENSITYHISTOGRAM_H
+
+#include <QVector>
+
+#include "taskscheduler.h"
+
+//Двумерная гистограмма пар значений двух каналов (фазовая плоскость) по целым прогонам.
+//Точки делятся на столько частей, сколько потоков; каждая часть копит свои счётчики,
+//которые складываются в конце. Точки вне заданной области не учитываются
+class DensityHistogram
+{
+public:
+    struct Series
+    {
+        QVector<float> x;
+        QVector<float> y;
+    };
+
+    struct Result
+    {
+        int columns;
+        int rows;
+        double xMin;
+        double xMax;
+        double yMin;
+        double yMax;
+        QVector<quint32> bins;//rows x columns, строка 0 - yMin
+        quint32 maxCount;
+        qint64 count;//точек внутри области
+        qint64 total;//всех точек с числовыми значениями
+    };
+
+    //xMin>=xMax или NaN - область по размаху данных
+    static Result compute(const QVector<Series> &series,double xMin,double xMax,double yMin,double yMax,
+                          int columns,int rows,const TaskScheduler::Token &token);
+};
+
+#endif // DENSITYHISTOGRAM_H
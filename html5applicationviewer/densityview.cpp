@@ -0,0 +1,254 @@
+#include "densityview.h"
+#include <QGridLayout>
+#include <QPainter>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <qnumeric.h>
+#include <cmath>
+
+#include "taskscheduler.h"
+
+static const int KBins = 400;//столбцов и строк гистограммы
+static const int KMargin = 40;//место под подписи осей
+static const double KWheelZoom = 1.25;
+
+namespace
+{
+struct DensityTask
+{
+    typedef DensityHistogram::Result result_type;
+    QVector<DensityHistogram::Series> series;
+    double xMin;
+    double xMax;
+    double yMin;
+    double yMax;
+    result_type operator()(const TaskScheduler::Token &token) const
+    {
+        return DensityHistogram::compute(series,xMin,xMax,yMin,yMax,KBins,KBins,token);
+    }
+};
+}
+
+DensityCanvas::DensityCanvas(QWidget *parent)
+    : QWidget(parent)
+    , m_result(0)
+    , m_image(0)
+{
+    setMinimumSize(300,300);
+}
+
+void DensityCanvas::setResult(const DensityHistogram::Result *result, const QImage *image, const QString &xName, const QString &yName)
+{
+    m_result=result;
+    m_image=image;
+    m_xName=xName;
+    m_yName=yName;
+    update();
+}
+
+QRect DensityCanvas::plotRect() const
+{
+    return rect().adjusted(KMargin,4,-4,-KMargin);
+}
+
+QPointF DensityCanvas::toData(const QPoint &point) const
+{
+    QRect plot=plotRect();
+    double fx=double(point.x()-plot.left())/qMax(1,plot.width());
+    double fy=double(plot.bottom()-point.y())/qMax(1,plot.height());
+    return QPointF(m_result->xMin+fx*(m_result->xMax-m_result->xMin),m_result->yMin+fy*(m_result->yMax-m_result->yMin));
+}
+
+void DensityCanvas::mousePressEvent(QMouseEvent *event)
+{
+    if(event->button()!=Qt::LeftButton)
+        return;
+    m_pressed=event->pos();
+    m_selection=QRect();
+}
+
+void DensityCanvas::mouseMoveEvent(QMouseEvent *event)
+{
+    if(!(event->buttons()&Qt::LeftButton))
+        return;
+    m_selection=QRect(m_pressed,event->pos()).normalized().intersected(plotRect());
+    update();
+}
+
+void DensityCanvas::mouseReleaseEvent(QMouseEvent *event)
+{
+    if(event->button()!=Qt::LeftButton)
+        return;
+    QRect selection=m_selection;
+    m_selection=QRect();
+    update();
+    if(!m_result || selection.width()<4 || selection.height()<4)
+        return;
+    QPointF low=toData(selection.bottomLeft());
+    QPointF high=toData(selection.topRight());
+    emit zoomRequested(low.x(),high.x(),low.y(),high.y());
+}
+
+void DensityCanvas::mouseDoubleClickEvent(QMouseEvent *)
+{
+    emit zoomReset();
+}
+
+void DensityCanvas::wheelEvent(QWheelEvent *event)
+{
+    if(!m_result)
+        return;
+    //приближение вокруг точки под курсором
+    double factor=event->angleDelta().y()>0 ? 1/KWheelZoom : KWheelZoom;
+    QPointF center=toData(event->pos());
+    emit zoomRequested(center.x()+(m_result->xMin-center.x())*factor,center.x()+(m_result->xMax-center.x())*factor,
+                       center.y()+(m_result->yMin-center.y())*factor,center.y()+(m_result->yMax-center.y())*factor);
+}
+
+void DensityCanvas::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(),Qt::white);
+    if(!m_result || m_image->isNull())
+        return;
+    QRect plot=plotRect();
+    painter.drawImage(plot,*m_image);
+    painter.setPen(Qt::darkGray);
+    painter.drawRect(plot.adjusted(0,0,-1,-1));
+    painter.setPen(Qt::black);
+    painter.drawText(QRect(plot.left(),plot.bottom()+2,plot.width(),16),Qt::AlignLeft,QString::number(m_result->xMin,'g',5));
+    painter.drawText(QRect(plot.left(),plot.bottom()+2,plot.width(),16),Qt::AlignRight,QString::number(m_result->xMax,'g',5));
+    painter.drawText(QRect(plot.left(),plot.bottom()+18,plot.width(),16),Qt::AlignHCenter,m_xName);
+    painter.save();
+    painter.translate(0,plot.bottom());
+    painter.rotate(-90);
+    painter.drawText(QRect(0,0,plot.height(),16),Qt::AlignLeft,QString::number(m_result->yMin,'g',5));
+    painter.drawText(QRect(0,0,plot.height(),16),Qt::AlignRight,QString::number(m_result->yMax,'g',5));
+    painter.drawText(QRect(0,16,plot.height(),16),Qt::AlignHCenter,m_yName);
+    painter.restore();
+    if(!m_selection.isNull())
+        painter.drawRect(m_selection);
+}
+
+DensityView::DensityView(GraphData &data, QWidget *parent)
+    : QWidget(parent,Qt::Window)
+    , m_data(data)
+    , m_xMin(qQNaN())
+    , m_xMax(qQNaN())
+    , m_yMin(qQNaN())
+    , m_yMax(qQNaN())
+{
+    setWindowTitle(tr("Density"));
+    m_run=new QComboBox;
+    m_x=new QComboBox;
+    m_y=new QComboBox;
+    m_status=new QLabel;
+    m_canvas=new DensityCanvas;
+    QGridLayout *layout=new QGridLayout;
+    layout->addWidget(m_run,0,0);
+    layout->addWidget(m_x,0,1);
+    layout->addWidget(m_y,0,2);
+    layout->addWidget(m_canvas,1,0,1,3);
+    layout->addWidget(m_status,2,0,1,3);
+    setLayout(layout);
+    connect(m_run,SIGNAL(activated(int)),SLOT(resetZoom()));
+    connect(m_x,SIGNAL(activated(int)),SLOT(resetZoom()));
+    connect(m_y,SIGNAL(activated(int)),SLOT(resetZoom()));
+    connect(m_canvas,SIGNAL(zoomRequested(double,double,double,double)),SLOT(zoom(double,double,double,double)));
+    connect(m_canvas,SIGNAL(zoomReset()),SLOT(resetZoom()));
+    connect(&m_watcher,SIGNAL(finished()),SLOT(computed()));
+    resize(600,600);
+}
+
+void DensityView::refreshLists(const QStringList &channelNames)
+{
+    QString run=m_run->currentText();
+    int x=m_x->currentIndex();
+    int y=m_y->currentIndex();
+    m_run->clear();
+    m_run->addItem(tr("All runs"));
+    for(int i=0;i<m_data.length();i++)
+        m_run->addItem(m_data.get_name(i));
+    m_x->clear();
+    m_x->addItems(channelNames);
+    m_y->clear();
+    m_y->addItems(channelNames);
+    m_run->setCurrentIndex(qMax(0,m_run->findText(run)));
+    m_x->setCurrentIndex(x<0 ? GraphData::DesiredWheelAngle : x);
+    m_y->setCurrentIndex(y<0 ? GraphData::CurrentWheelAngle : y);
+    request();
+}
+
+void DensityView::zoom(double xMin, double xMax, double yMin, double yMax)
+{
+    m_xMin=xMin;
+    m_xMax=xMax;
+    m_yMin=yMin;
+    m_yMax=yMax;
+    request();
+}
+
+void DensityView::resetZoom()
+{
+    zoom(qQNaN(),qQNaN(),qQNaN(),qQNaN());
+}
+
+void DensityView::request()
+{
+    DensityTask task;
+    for(int i=0;i<m_data.length();i++)
+    {
+        if(m_run->currentIndex()>0 && m_data.get_name(i)!=m_run->currentText())
+            continue;
+        //копии общие с GraphData до первого изменения, задача не зависит от загрузки новых прогонов
+        DensityHistogram::Series series;
+        series.x=m_data.column(i,m_x->currentIndex());
+        series.y=m_data.column(i,m_y->currentIndex());
+        task.series<<series;
+    }
+    if(task.series.isEmpty() || m_x->currentIndex()<0 || m_y->currentIndex()<0)
+    {
+        m_canvas->setResult(0,0,QString(),QString());
+        m_status->setText(tr("No run loaded"));
+        return;
+    }
+    task.xMin=m_xMin;
+    task.xMax=m_xMax;
+    task.yMin=m_yMin;
+    task.yMax=m_yMax;
+    //прежняя область больше не нужна: её подсчёт отменяется, показывается только последняя
+    m_watcher.cancel();
+    m_status->setText(tr("Binning..."));
+    m_watcher.setFuture(TaskScheduler::run(TaskScheduler::VisibleRuns,task));
+}
+
+void DensityView::computed()
+{
+    if(m_watcher.isCanceled())
+        return;
+    m_result=m_watcher.result();
+    m_image=render(m_result);
+    m_canvas->setResult(&m_result,&m_image,m_x->currentText(),m_y->currentText());
+    m_status->setText(tr("%1 of %2 points in view, densest bin %3").arg(m_result.count).arg(m_result.total).arg(m_result.maxCount));
+}
+
+//Логарифмическая шкала: редкие области видны рядом с плотными; пустые ячейки белые
+QImage DensityView::render(const DensityHistogram::Result &result)
+{
+    QImage image(result.columns,result.rows,QImage::Format_RGB32);
+    image.fill(Qt::white);
+    const double scale=result.maxCount>0 ? 1/std::log(1.0+result.maxCount) : 0;
+    for(int row=0;row<result.rows;row++)
+    {
+        QRgb *line=(QRgb*)image.scanLine(result.rows-1-row);
+        const quint32 *counts=result.bins.constData()+row*result.columns;
+        for(int c=0;c<result.columns;c++)
+        {
+            if(counts[c]==0)
+                continue;
+            float v=float(std::log(1.0+counts[c])*scale);
+            line[c]=QColor::fromHsvF(0.66*(1-v),1,1-0.3*v).rgb();
+        }
+    }
+    return image;
+}
@@ -0,0 +1,71 @@
+#ifndef DENSITYVIEW_H
+#define DENSITYVIEW_H
+
+#include <QWidget>
+#include <QComboBox>
+#include <QLabel>
+#include <QImage>
+#include <QFutureWatcher>
+
+#include "graphdata.h"
+#include "densityhistogram.h"
+
+//Область рисования плотности: выделение рамкой или колесо приближают, двойной щелчок - весь размах
+class DensityCanvas : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit DensityCanvas(QWidget *parent = 0);
+    void setResult(const DensityHistogram::Result *result,const QImage *image,const QString &xName,const QString &yName);
+signals:
+    void zoomRequested(double xMin,double xMax,double yMin,double yMax);
+    void zoomReset();
+protected:
+    void paintEvent(QPaintEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+    void mouseReleaseEvent(QMouseEvent *event);
+    void mouseDoubleClickEvent(QMouseEvent *event);
+    void wheelEvent(QWheelEvent *event);
+private:
+    const DensityHistogram::Result *m_result;
+    const QImage *m_image;
+    QString m_xName;
+    QString m_yName;
+    QPoint m_pressed;
+    QRect m_selection;
+    QRect plotRect() const;
+    QPointF toData(const QPoint &point) const;
+};
+
+//Фазовая плоскость: плотность пар значений двух каналов по одному или всем прогонам.
+//Гистограмма пересчитывается в фоне при каждой смене области, отдельные точки не рисуются
+class DensityView : public QWidget
+{
+    Q_OBJECT
+public:
+    DensityView(GraphData &data,QWidget *parent = 0);
+    void refreshLists(const QStringList &channelNames);
+private slots:
+    void request();
+    void computed();
+    void zoom(double xMin,double xMax,double yMin,double yMax);
+    void resetZoom();
+private:
+    GraphData &m_data;
+    QComboBox *m_run;//"All runs" или один прогон
+    QComboBox *m_x;
+    QComboBox *m_y;
+    QLabel *m_status;
+    DensityCanvas *m_canvas;
+    DensityHistogram::Result m_result;
+    QImage m_image;
+    double m_xMin;//видимая область; NaN - весь размах
+    double m_xMax;
+    double m_yMin;
+    double m_yMax;
+    QFutureWatcher<DensityHistogram::Result> m_watcher;
+    static QImage render(const DensityHistogram::Result &result);
+};
+
+#endif // DENSITYVIEW_H
@@ -0,0 +1,226 @@
+#include "eventdetector.h"
+#include "taskscheduler.h"
+#include <qnumeric.h>
+#include <algorithm>
+#include <cmath>
+
+static const float KSaturationFraction = 0.99f;//упор - модуль угла не меньше 99% максимального по прогону
+static const float KJitterTolerance = 0.5f;//допустимое отклонение шага от медианы
+static const int KMinSaturationSamples = 10;
+static const int KTimestepSamples = 4096;//шагов в выборке для медианы
+static const int KMergeGap = 5;//события одного типа ближе этого числа отсчётов сливаются
+
+namespace
+{
+inline quint32 bit(bool value,int shift)
+{
+    return quint32(value)<<shift;
+}
+
+//x-x не равно нулю только для NaN и бесконечностей, без ветвлений
+inline bool nonFinite(float x)
+{
+    return !(x-x==0.0f);
+}
+
+bool eventBefore(const EventDetector::Event &a,const EventDetector::Event &b)
+{
+    return a.begin<b.begin;
+}
+
+struct DetectTask
+{
+    typedef QVector<EventDetector::Event> result_type;
+    EventDetector::Input input;
+    result_type operator()(const TaskScheduler::Token &) const
+    {
+        EventDetector::Input measured=input;
+        EventDetector::measureLevels(measured);
+        return EventDetector::detect(measured);
+    }
+};
+}
+
+EventDetector::EventDetector(GraphData &data, QObject *parent)
+    : QObject(parent)
+    , m_data(data)
+{
+
+}
+
+EventDetector::Input EventDetector::snapshot(GraphData &data, int run, const QList<Condition> &conditions)
+{
+    Input input;
+    input.time=data.time(run);
+    for(int c=0;c<GraphData::ChannelCount;c++)
+        input.channels[c]=data.column(run,c);
+    input.conditions=conditions;
+    for(int i=0;i<conditions.size();i++)
+        input.conditionColumns<<data.column(run,conditions[i].channel);
+    input.saturationLevel=qInf();
+    input.medianTimestep=qQNaN();
+    return input;
+}
+
+//уровни по всему прогону меряются в потоке сканирования, а не в потоке интерфейса:
+//модуль угла - один проход, медиана шага - по выборке, как в SpectrumAnalysis
+void EventDetector::measureLevels(Input &input)
+{
+    const QVector<float> &angles=input.channels[GraphData::CurrentWheelAngle];
+    const QVector<float> &steps=input.channels[GraphData::PhysicsTimestep];
+    float limit=0;
+    for(int i=0;i<angles.size();i++)
+        if(qIsFinite(angles[i]))
+            limit=qMax(limit,std::fabs(angles[i]));
+    input.saturationLevel=limit>0 ? limit*KSaturationFraction : qInf();
+
+    QVector<float> sample;
+    const int stride=qMax(1,steps.size()/KTimestepSamples);
+    for(int i=0;i<steps.size();i+=stride)
+        if(qIsFinite(steps[i]))
+            sample.append(steps[i]);
+    if(sample.isEmpty())
+    {
+        input.medianTimestep=qQNaN();
+        return;
+    }
+    std::nth_element(sample.begin(),sample.begin()+sample.size()/2,sample.end());
+    input.medianTimestep=sample[sample.size()/2];
+}
+
+QVector<EventDetector::Event> EventDetector::detect(const Input &input)
+{
+    const int n=input.time.size();
+    const int conditionCount=qMin(input.conditions.size(),int(KMaxConditions));
+    const int bits=Threshold+conditionCount;
+    QVector<quint32> flags(n);
+
+    //один проход по всем столбцам: каждый отсчёт превращается в маску условий
+    const float *line=input.channels[GraphData::LinePosition].constData();
+    const float *dt=input.channels[GraphData::PhysicsTimestep].constData();
+    const float *angle=input.channels[GraphData::CurrentWheelAngle].constData();
+    const float median=input.medianTimestep;
+    const float jitter=qIsFinite(median) && median>0 ? median*KJitterTolerance : qInf();
+    const float saturation=input.saturationLevel;
+    for(int i=0;i<n;i++)
+    {
+        bool invalid=false;
+        for(int c=0;c<GraphData::ChannelCount;c++)
+            if(c!=GraphData::LinePosition)
+                invalid|=nonFinite(input.channels[c][i]);
+        quint32 f=bit(line[i]!=line[i],LineLost)
+                | bit(invalid,NonFinite)
+                | bit(std::fabs(dt[i]-median)>jitter,TimestepJitter)
+                | bit(std::fabs(angle[i])>=saturation,SteeringSaturation);
+        for(int k=0;k<conditionCount;k++)
+        {
+            const Condition &condition=input.conditions[k];
+            float v=input.conditionColumns[k][i];
+            f|=bit(condition.above ? v>condition.level : v<condition.level,Threshold+k);
+        }
+        flags[i]=f;
+    }
+
+    //маски сворачиваются в отрезки
+    QVector<Event> events;
+    QVector<int> start(bits,-1);
+    QVector<int> last(bits,-1);
+    for(int i=0;i<=n;i++)
+    {
+        const quint32 f=i<n ? flags[i] : 0;
+        for(int b=0;b<bits;b++)
+        {
+            const bool set=f>>b&1;
+            if(set && start[b]>=0 && i-last[b]<=KMergeGap)
+            {
+                last[b]=i;
+                continue;
+            }
+            if(start[b]>=0 && (set || i-last[b]>KMergeGap || i==n))
+            {
+                Event e;
+                e.type=b<Threshold ? Type(b) : Threshold;
+                e.channel=b<Threshold ? -1 : input.conditions[b-Threshold].channel;
+                e.begin=start[b];
+                e.end=last[b]+1;
+                e.tBegin=input.time[e.begin];
+                e.tEnd=input.time[e.end-1];
+                if(e.type!=SteeringSaturation || e.end-e.begin>=KMinSaturationSamples)
+                    events.append(e);
+                start[b]=-1;
+            }
+            if(set)
+                start[b]=last[b]=i;
+        }
+    }
+    std::sort(events.begin(),events.end(),eventBefore);
+    return events;
+}
+
+void EventDetector::scan(const QString &run)
+{
+    int index=m_data.findByName(run);
+    if(index==-1)
+        return;
+    invalidate(run);
+    Watcher *watcher=new Watcher(this);
+    connect(watcher,SIGNAL(finished()),SLOT(scanned()));
+    m_pending.insert(run,watcher);
+    DetectTask task;
+    task.input=snapshot(m_data,index,m_conditions);
+    watcher->setFuture(TaskScheduler::run(TaskScheduler::VisibleRuns,task));
+}
+
+void EventDetector::scanned()
+{
+    Watcher *watcher=static_cast<Watcher*>(sender());
+    QString run=m_pending.key(watcher);
+    watcher->deleteLater();
+    if(run.isEmpty())
+        return;
+    m_pending.remove(run);
+    m_events.insert(run,watcher->result());
+    emit changed();
+}
+
+void EventDetector::invalidate(const QString &run)
+{
+    //ещё не начатое сканирование не запустится, результат идущего просто не будет принят
+    Watcher *watcher=m_pending.take(run);
+    if(watcher)
+    {
+        watcher->cancel();
+        disconnect(watcher,0,this,0);
+        connect(watcher,SIGNAL(finished()),watcher,SLOT(deleteLater()));
+    }
+    if(m_events.remove(run))
+        emit changed();
+}
+
+bool EventDetector::addCondition(const Condition &condition)
+{
+    if(m_conditions.size()>=KMaxConditions)
+        return false;
+    m_conditions<<condition;
+    for(int i=0;i<m_data.length();i++)
+        scan(m_data.get_name(i));
+    return true;
+}
+
+QVector<EventDetector::Event> EventDetector::events(const QString &run) const
+{
+    return m_events.value(run);
+}
+
+QString EventDetector::typeName(Type type)
+{
+    switch(type)
+    {
+    case LineLost: return "Line lost";
+    case NonFinite: return "NaN/inf";
+    case TimestepJitter: return "Timestep jitter";
+    case SteeringSaturation: return "Steering saturation";
+    case Threshold: return "Threshold";
+    }
+    return QString();
+}
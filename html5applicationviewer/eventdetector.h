@@ -0,0 +1,78 @@
+#ifndef EVENTDETECTOR_H
+#define EVENTDETECTOR_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QFutureWatcher>
+
+#include "graphdata.h"
+
+//Индекс характерных моментов прогона: потеря линии, всплески NaN/inf,
+//скачки шага физики, упор руля и пороги по любому каналу. Строится в фоне при загрузке
+class EventDetector : public QObject
+{
+    Q_OBJECT
+public:
+    enum Type{LineLost,NonFinite,TimestepJitter,SteeringSaturation,Threshold};
+
+    struct Event
+    {
+        Type type;
+        int channel;//для Threshold, иначе -1
+        int begin;//отсчёты [begin,end)
+        int end;
+        double tBegin;
+        double tEnd;
+    };
+
+    struct Condition
+    {
+        int channel;
+        bool above;//true: value>level, false: value<level
+        float level;
+    };
+
+    //неглубокие копии столбцов, чтобы сканировать в другом потоке, пока GraphData меняется
+    struct Input
+    {
+        QVector<double> time;
+        QVector<float> channels[GraphData::ChannelCount];
+        QList<QVector<float> > conditionColumns;
+        QList<Condition> conditions;
+        float saturationLevel;//заполняет measureLevels
+        float medianTimestep;
+    };
+
+    static const int KMaxConditions = 27;
+
+    explicit EventDetector(GraphData &data,QObject *parent = 0);
+
+    void scan(const QString &run);
+    void invalidate(const QString &run);
+    bool addCondition(const Condition &condition);
+    QList<Condition> conditions() const {return m_conditions;}
+    QVector<Event> events(const QString &run) const;
+    static QString typeName(Type type);
+
+    static Input snapshot(GraphData &data,int run,const QList<Condition> &conditions);
+    static void measureLevels(Input &input);
+    static QVector<Event> detect(const Input &input);
+
+signals:
+    void changed();
+
+private slots:
+    void scanned();
+
+private:
+    typedef QFutureWatcher<QVector<Event> > Watcher;
+    GraphData &m_data;
+    QList<Condition> m_conditions;
+    QHash<QString,QVector<Event> > m_events;
+    QHash<QString,Watcher*> m_pending;
+};
+
+#endif // EVENTDETECTOR_H
@@ -0,0 +1,35 @@
+#include "fft.h"
+#include <cmath>
+#include <utility>
+
+static const double KPi = 3.14159265358979323846;
+
+void fft(std::complex<float> *data, int n)
+{
+    for(int i=1,j=0;i<n;i++)
+    {
+        int bit=n>>1;
+        for(;j&bit;bit>>=1)
+            j^=bit;
+        j^=bit;
+        if(i<j)
+            std::swap(data[i],data[j]);
+    }
+    for(int length=2;length<=n;length<<=1)
+    {
+        const double angle=-2*KPi/length;
+        const std::complex<double> step(std::cos(angle),std::sin(angle));
+        for(int i=0;i<n;i+=length)
+        {
+            std::complex<double> w(1,0);
+            for(int k=0;k<length/2;k++)
+            {
+                std::complex<float> u=data[i+k];
+                std::complex<float> v=data[i+k+length/2]*std::complex<float>(w);
+                data[i+k]=u+v;
+                data[i+k+length/2]=u-v;
+                w*=step;
+            }
+        }
+    }
+}
@@ -0,0 +1,10 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+
+//Итеративное БПФ по основанию 2 (Cooley-Tukey), на месте.
+//n должно быть степенью двойки
+void fft(std::complex<float> *data,int n);
+
+#endif // FFT_H
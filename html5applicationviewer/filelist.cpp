@@ -0,0 +1,299 @@
+#include "filelist.h"
+#include "logcatalog.h"
+#include "taskscheduler.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <QPainter>
+#include <QMouseEvent>
+#include <QApplication>
+
+static const int KRowHeight = 24;
+static const int KSwatchSize = 10;
+static const int KButtonSize = 20;
+
+namespace
+{
+//заголовки читаются вне потока интерфейса: сетевой диск может отвечать секундами
+struct CountRecords
+{
+    typedef QHash<QString,qint64> result_type;
+
+    QVector<QPair<QString,qint64> > files;
+
+    result_type operator()(const TaskScheduler::Token &token) const
+    {
+        result_type counts;
+        for(int i=0;i<files.size() && !token.isCancelled();i++)
+            counts.insert(files[i].first,FileListModel::recordCount(files[i].first,files[i].second));
+        return counts;
+    }
+};
+}
+
+FileListModel::FileListModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    connect(&m_counter,SIGNAL(finished()),SLOT(countsReady()));
+}
+
+FileListModel::Entry FileListModel::makeEntry(const QString &path, const QString &label)
+{
+    QFileInfo info(path);
+    Entry entry;
+    entry.path=path;
+    entry.label=label.isEmpty() ? info.fileName() : label;
+    entry.size=info.size();
+    entry.modified=info.lastModified().toMSecsSinceEpoch();
+    entry.records=-1;
+    entry.checked=false;
+    return entry;
+}
+
+qint64 FileListModel::recordCount(const QString &path, qint64 size)
+{
+    //достаточно заголовка: записи фиксированной длины
+    quint32 version;
+    qint64 records;
+    return LogCatalog::readHeader(path,size,&version,&records) ? records : 0;
+}
+
+int FileListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_entries.size();
+}
+
+QVariant FileListModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row()>=m_entries.size())
+        return QVariant();
+    const Entry &entry=m_entries[index.row()];
+    switch(role)
+    {
+    case Qt::DisplayRole:
+        return entry.label;
+    case Qt::ToolTipRole:
+    case PathRole:
+        return entry.path;
+    case Qt::CheckStateRole:
+        return entry.checked ? Qt::Checked : Qt::Unchecked;
+    case SizeRole:
+        return entry.size;
+    case ModifiedRole:
+        return entry.modified;
+    case RecordsRole:
+        return entry.records;
+    case ColorRole:
+        return entry.color;
+    }
+    return QVariant();
+}
+
+bool FileListModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if(!index.isValid() || role!=Qt::CheckStateRole)
+        return false;
+    Entry &entry=m_entries[index.row()];
+    bool checked=value.toInt()==Qt::Checked;
+    if(entry.checked==checked)
+        return true;
+    entry.checked=checked;
+    if(!checked)
+        entry.color=QColor();
+    emit dataChanged(index,index);
+    emit checkChanged(index.row(),checked);
+    return true;
+}
+
+Qt::ItemFlags FileListModel::flags(const QModelIndex &index) const
+{
+    if(!index.isValid())
+        return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled|Qt::ItemIsUserCheckable;
+}
+
+void FileListModel::addFiles(const QVector<Entry> &entries)
+{
+    QVector<Entry> fresh;
+    fresh.reserve(entries.size());
+    for(int i=0;i<entries.size();i++)
+        if(!m_rows.contains(entries[i].path))
+        {
+            m_rows.insert(entries[i].path,m_entries.size()+fresh.size());
+            fresh.append(entries[i]);
+            fresh.last().label=uniqueLabel(entries[i]);
+            m_labels.insert(fresh.last().label);
+        }
+    if(fresh.isEmpty())
+        return;
+    //одна вставка на пачку, чтобы представление перестраивалось один раз
+    beginInsertRows(QModelIndex(),m_entries.size(),m_entries.size()+fresh.size()-1);
+    m_entries+=fresh;
+    endInsertRows();
+    for(int i=0;i<fresh.size();i++)
+        if(fresh[i].records<0)
+            m_uncounted.append(qMakePair(fresh[i].path,fresh[i].size));
+    countRecords();
+}
+
+void FileListModel::countRecords()
+{
+    if(m_counter.isRunning() || m_uncounted.isEmpty())
+        return;
+    //строки уже видны, поэтому раньше упреждающей работы
+    CountRecords task;
+    task.files=m_uncounted;
+    m_uncounted.clear();
+    m_counter.setFuture(TaskScheduler::run(TaskScheduler::VisibleRuns,task));
+}
+
+void FileListModel::countsReady()
+{
+    if(!m_counter.isCanceled())
+    {
+        //пока шло чтение, строки могли удалить или сдвинуть - ищутся по пути
+        const QHash<QString,qint64> counts=m_counter.result();
+        for(QHash<QString,qint64>::const_iterator i=counts.constBegin();i!=counts.constEnd();++i)
+        {
+            const int row=m_rows.value(i.key(),-1);
+            if(row==-1 || m_entries[row].records>=0)
+                continue;
+            m_entries[row].records=i.value();
+            emit dataChanged(index(row),index(row),QVector<int>()<<RecordsRole);
+        }
+    }
+    countRecords();
+}
+
+void FileListModel::addFile(const QString &path, const QString &label)
+{
+    addFiles(QVector<Entry>()<<makeEntry(path,label));
+}
+
+void FileListModel::removeFile(int row)
+{
+    beginRemoveRows(QModelIndex(),row,row);
+    m_rows.remove(m_entries[row].path);
+    m_labels.remove(m_entries[row].label);
+    m_entries.remove(row);
+    for(int i=row;i<m_entries.size();i++)
+        m_rows[m_entries[i].path]=i;
+    endRemoveRows();
+}
+
+int FileListModel::find(const QString &path) const
+{
+    return m_rows.value(path,-1);
+}
+
+int FileListModel::findLabel(const QString &label) const
+{
+    for(int i=0;i<m_entries.size();i++)
+        if(m_entries[i].label==label)
+            return i;
+    return -1;
+}
+
+QString FileListModel::uniqueLabel(const Entry &entry) const
+{
+    //прогоны в GraphData, загрузчике и сравнении различаются по имени: одноимённые файлы
+    //из разных каталогов получают полный путь, а если занят и он - номер
+    if(!m_labels.contains(entry.label))
+        return entry.label;
+    if(!m_labels.contains(entry.path))
+        return entry.path;
+    for(int n=2;;n++)
+    {
+        QString label=QString("%1 (%2)").arg(entry.label).arg(n);
+        if(!m_labels.contains(label))
+            return label;
+    }
+}
+
+QList<int> FileListModel::checkedRows() const
+{
+    QList<int> rows;
+    for(int i=0;i<m_entries.size();i++)
+        if(m_entries[i].checked)
+            rows<<i;
+    return rows;
+}
+
+void FileListModel::setColor(const QString &label, const QColor &color)
+{
+    for(int i=0;i<m_entries.size();i++)
+        if(m_entries[i].checked && m_entries[i].label==label)
+        {
+            m_entries[i].color=color;
+            emit dataChanged(index(i),index(i));
+        }
+}
+
+FileListDelegate::FileListDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+
+}
+
+QRect FileListDelegate::buttonRect(const QRect &rect)
+{
+    return QRect(rect.right()-KButtonSize-2,rect.center().y()-KButtonSize/2,KButtonSize,KButtonSize);
+}
+
+QSize FileListDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    return QSize(QStyledItemDelegate::sizeHint(option,index).width(),KRowHeight);
+}
+
+void FileListDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    QStyle *style=option.widget ? option.widget->style() : QApplication::style();
+    const QRect button=buttonRect(option.rect);
+    QColor color=index.data(FileListModel::ColorRole).value<QColor>();
+
+    //флажок и имя рисует стандартный делегат, справа оставляется место под размер и кнопку
+    QStyleOptionViewItem item(option);
+    initStyleOption(&item,index);
+    item.rect.setRight(button.left()-2);
+    if(color.isValid())
+        item.rect.setLeft(item.rect.left()+KSwatchSize+4);
+    qint64 records=index.data(FileListModel::RecordsRole).toLongLong();
+    qint64 size=index.data(FileListModel::SizeRole).toLongLong();
+    QString meta=size>=1024*1024 ? QString::number(size/(1024.0*1024.0),'f',1)+" MB" : QString::number(size/1024)+" KB";
+    if(records>=0)
+        meta+=", "+QString::number(records);
+    int metaWidth=option.fontMetrics.width(meta)+6;
+    item.rect.setRight(item.rect.right()-metaWidth);
+    style->drawControl(QStyle::CE_ItemViewItem,&item,painter,option.widget);
+
+    if(color.isValid())
+    {
+        QRect swatch(option.rect.left()+2,option.rect.center().y()-KSwatchSize/2,KSwatchSize,KSwatchSize);
+        painter->fillRect(swatch,color);
+    }
+    painter->save();
+    painter->setPen(option.palette.color(QPalette::Disabled,QPalette::Text));
+    painter->drawText(QRect(item.rect.right(),option.rect.top(),metaWidth,option.rect.height()),Qt::AlignRight|Qt::AlignVCenter,meta);
+    painter->restore();
+
+    QStyleOptionButton buttonOption;
+    buttonOption.rect=button;
+    buttonOption.text="x";
+    buttonOption.state=QStyle::State_Enabled|QStyle::State_Raised;
+    style->drawControl(QStyle::CE_PushButton,&buttonOption,painter,option.widget);
+}
+
+bool FileListDelegate::editorEvent(QEvent *event, QAbstractItemModel *model, const QStyleOptionViewItem &option, const QModelIndex &index)
+{
+    if(event->type()==QEvent::MouseButtonDblClick)
+        return true;
+    if(event->type()!=QEvent::MouseButtonRelease || static_cast<QMouseEvent*>(event)->button()!=Qt::LeftButton)
+        return false;
+    if(buttonRect(option.rect).contains(static_cast<QMouseEvent*>(event)->pos()))
+    {
+        emit deleteRequested(index);
+        return true;
+    }
+    //щелчок по строке переключает флажок, как было со списком виджетов
+    bool checked=index.data(Qt::CheckStateRole).toInt()==Qt::Checked;
+    return model->setData(index,checked ? Qt::Unchecked : Qt::Checked,Qt::CheckStateRole);
+}
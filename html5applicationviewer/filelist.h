@@ -0,0 +1,81 @@
+#ifndef FILELIST_H
+#define FILELIST_H
+
+#include <QAbstractListModel>
+#include <QStyledItemDelegate>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QColor>
+#include <QStringList>
+#include <QFutureWatcher>
+
+//Список открытых логов без виджета на каждую строку: данные в модели,
+//флажок, цвет прогона и кнопка удаления рисуются делегатом
+class FileListModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Role{PathRole=Qt::UserRole,SizeRole,RecordsRole,ModifiedRole,ColorRole};
+
+    struct Entry
+    {
+        QString path;
+        QString label;//имя прогона в GraphData, в списке не повторяется
+        qint64 size;
+        qint64 modified;//мс от эпохи
+        qint64 records;//-1 - ещё не прочитано, заголовок читается в фоне
+        bool checked;
+        QColor color;
+    };
+
+    explicit FileListModel(QObject *parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index,int role) const;
+    bool setData(const QModelIndex &index,const QVariant &value,int role);
+    Qt::ItemFlags flags(const QModelIndex &index) const;
+
+    void addFiles(const QVector<Entry> &entries);
+    void addFile(const QString &path,const QString &label = QString());
+    void removeFile(int row);
+    int find(const QString &path) const;
+    int findLabel(const QString &label) const;
+    const Entry &entry(int row) const {return m_entries[row];}
+    QList<int> checkedRows() const;
+    void setColor(const QString &label,const QColor &color);
+
+    static Entry makeEntry(const QString &path,const QString &label = QString());
+    static qint64 recordCount(const QString &path,qint64 size);
+
+signals:
+    void checkChanged(int row,bool checked);
+
+private slots:
+    void countsReady();
+
+private:
+    QVector<Entry> m_entries;
+    QHash<QString,int> m_rows;//путь -> строка, для отсева повторов
+    QSet<QString> m_labels;
+    QFutureWatcher<QHash<QString,qint64> > m_counter;
+    QVector<QPair<QString,qint64> > m_uncounted;//путь и размер, ждут своей очереди
+    void countRecords();
+    QString uniqueLabel(const Entry &entry) const;
+};
+
+class FileListDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    explicit FileListDelegate(QObject *parent = 0);
+    void paint(QPainter *painter,const QStyleOptionViewItem &option,const QModelIndex &index) const;
+    QSize sizeHint(const QStyleOptionViewItem &option,const QModelIndex &index) const;
+    bool editorEvent(QEvent *event,QAbstractItemModel *model,const QStyleOptionViewItem &option,const QModelIndex &index);
+signals:
+    void deleteRequested(const QModelIndex &index);
+private:
+    static QRect buttonRect(const QRect &rect);
+};
+
+#endif // FILELIST_H
@@ -0,0 +1,334 @@
+#include "floatformat.h"
+#include <cstdio>
+
+//Ryu (Ulf Adams, 2018) для float32: таблицы степеней пятёрки
+//и целочисленная арифметика вместо перебора точности со сверкой через strtof
+static const int KPow5InvBitCount = 59;
+static const int KPow5BitCount = 61;
+
+static const quint64 KPow5InvSplit[31] = {
+    576460752303423489ull, 461168601842738791ull, 368934881474191033ull,
+    295147905179352826ull, 472236648286964522ull, 377789318629571618ull,
+    302231454903657294ull, 483570327845851670ull, 386856262276681336ull,
+    309485009821345069ull, 495176015714152110ull, 396140812571321688ull,
+    316912650057057351ull, 507060240091291761ull, 405648192073033409ull,
+    324518553658426727ull, 519229685853482763ull, 415383748682786211ull,
+    332306998946228969ull, 531691198313966350ull, 425352958651173080ull,
+    340282366920938464ull, 544451787073501542ull, 435561429658801234ull,
+    348449143727040987ull, 557518629963265579ull, 446014903970612463ull,
+    356811923176489971ull, 570899077082383953ull, 456719261665907162ull,
+    365375409332725730ull
+};
+
+static const quint64 KPow5Split[47] = {
+    1152921504606846976ull, 1441151880758558720ull, 1801439850948198400ull,
+    2251799813685248000ull, 1407374883553280000ull, 1759218604441600000ull,
+    2199023255552000000ull, 1374389534720000000ull, 1717986918400000000ull,
+    2147483648000000000ull, 1342177280000000000ull, 1677721600000000000ull,
+    2097152000000000000ull, 1310720000000000000ull, 1638400000000000000ull,
+    2048000000000000000ull, 1280000000000000000ull, 1600000000000000000ull,
+    2000000000000000000ull, 1250000000000000000ull, 1562500000000000000ull,
+    1953125000000000000ull, 1220703125000000000ull, 1525878906250000000ull,
+    1907348632812500000ull, 1192092895507812500ull, 1490116119384765625ull,
+    1862645149230957031ull, 1164153218269348144ull, 1455191522836685180ull,
+    1818989403545856475ull, 2273736754432320594ull, 1421085471520200371ull,
+    1776356839400250464ull, 2220446049250313080ull, 1387778780781445675ull,
+    1734723475976807094ull, 2168404344971008868ull, 1355252715606880542ull,
+    1694065894508600678ull, 2117582368135750847ull, 1323488980084844279ull,
+    1654361225106055349ull, 2067951531382569187ull, 1292469707114105741ull,
+    1615587133892632177ull, 2019483917365790221ull
+};
+
+static const quint64 KPow10[] = {
+    1ull,10ull,100ull,1000ull,10000ull,100000ull,1000000ull,10000000ull,100000000ull,1000000000ull,
+    10000000000ull,100000000000ull,1000000000000ull,10000000000000ull,100000000000000ull,
+    1000000000000000ull,10000000000000000ull,100000000000000000ull,1000000000000000000ull};
+
+namespace
+{
+inline int pow5bits(int e)
+{
+    return int((quint32(e)*1217359)>>19)+1;
+}
+
+inline int log10Pow2(int e)
+{
+    return int((quint32(e)*78913)>>18);
+}
+
+inline int log10Pow5(int e)
+{
+    return int((quint32(e)*732923)>>20);
+}
+
+inline int pow5Factor(quint32 value)
+{
+    int count=0;
+    for(;value%5==0;value/=5)
+        count++;
+    return count;
+}
+
+inline bool multipleOfPowerOf5(quint32 value,int p)
+{
+    return pow5Factor(value)>=p;
+}
+
+inline bool multipleOfPowerOf2(quint32 value,int p)
+{
+    return (value&((1u<<p)-1))==0;
+}
+
+inline quint32 mulShift(quint32 m,quint64 factor,int shift)
+{
+    const quint64 low=quint64(m)*quint32(factor);
+    const quint64 high=quint64(m)*quint32(factor>>32);
+    return quint32(((low>>32)+high)>>(shift-32));
+}
+
+inline int digitCount(quint32 value)
+{
+    int n=1;
+    while(n<10 && value>=KPow10[n])
+        n++;
+    return n;
+}
+
+//мантисса в десятичном виде: value = digits * 10^exponent
+void decimal(quint32 ieeeMantissa,quint32 ieeeExponent,quint32 &digits,int &exponent)
+{
+    int e2;
+    quint32 m2;
+    if(ieeeExponent==0)
+    {
+        e2=1-127-23-2;
+        m2=ieeeMantissa;
+    }
+    else
+    {
+        e2=int(ieeeExponent)-127-23-2;
+        m2=(1u<<23)|ieeeMantissa;
+    }
+    const bool acceptBounds=(m2&1)==0;
+    const quint32 mv=4*m2;
+    const quint32 mp=4*m2+2;
+    const quint32 mmShift=ieeeMantissa!=0 || ieeeExponent<=1;
+    const quint32 mm=4*m2-1-mmShift;
+
+    quint32 vr,vp,vm;
+    int e10;
+    bool vmIsTrailingZeros=false;
+    bool vrIsTrailingZeros=false;
+    quint32 lastRemovedDigit=0;
+    if(e2>=0)
+    {
+        const int q=log10Pow2(e2);
+        e10=q;
+        const int k=KPow5InvBitCount+pow5bits(q)-1;
+        const int i=-e2+q+k;
+        vr=mulShift(mv,KPow5InvSplit[q],i);
+        vp=mulShift(mp,KPow5InvSplit[q],i);
+        vm=mulShift(mm,KPow5InvSplit[q],i);
+        if(q!=0 && (vp-1)/10<=vm/10)
+        {
+            const int l=KPow5InvBitCount+pow5bits(q-1)-1;
+            lastRemovedDigit=mulShift(mv,KPow5InvSplit[q-1],-e2+q-1+l)%10;
+        }
+        if(q<=9)
+        {
+            if(mv%5==0)
+                vrIsTrailingZeros=multipleOfPowerOf5(mv,q);
+            else if(acceptBounds)
+                vmIsTrailingZeros=multipleOfPowerOf5(mm,q);
+            else
+                vp-=multipleOfPowerOf5(mp,q);
+        }
+    }
+    else
+    {
+        const int q=log10Pow5(-e2);
+        e10=q+e2;
+        const int i=-e2-q;
+        const int k=pow5bits(i)-KPow5BitCount;
+        int j=q-k;
+        vr=mulShift(mv,KPow5Split[i],j);
+        vp=mulShift(mp,KPow5Split[i],j);
+        vm=mulShift(mm,KPow5Split[i],j);
+        if(q!=0 && (vp-1)/10<=vm/10)
+        {
+            j=q-1-(pow5bits(i+1)-KPow5BitCount);
+            lastRemovedDigit=mulShift(mv,KPow5Split[i+1],j)%10;
+        }
+        if(q<=1)
+        {
+            vrIsTrailingZeros=true;
+            if(acceptBounds)
+                vmIsTrailingZeros=mmShift==1;
+            else
+                vp--;
+        }
+        else if(q<31)
+            vrIsTrailingZeros=multipleOfPowerOf2(mv,q-1);
+    }
+
+    int removed=0;
+    if(vmIsTrailingZeros || vrIsTrailingZeros)
+    {
+        while(vp/10>vm/10)
+        {
+            vmIsTrailingZeros&=vm%10==0;
+            vrIsTrailingZeros&=lastRemovedDigit==0;
+            lastRemovedDigit=vr%10;
+            vr/=10;
+            vp/=10;
+            vm/=10;
+            removed++;
+        }
+        if(vmIsTrailingZeros)
+        {
+            while(vm%10==0)
+            {
+                vrIsTrailingZeros&=lastRemovedDigit==0;
+                lastRemovedDigit=vr%10;
+                vr/=10;
+                vp/=10;
+                vm/=10;
+                removed++;
+            }
+        }
+        if(vrIsTrailingZeros && lastRemovedDigit==5 && vr%2==0)
+            lastRemovedDigit=4;
+        digits=vr+((vr==vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit>=5);
+    }
+    else
+    {
+        while(vp/10>vm/10)
+        {
+            lastRemovedDigit=vr%10;
+            vr/=10;
+            vp/=10;
+            vm/=10;
+            removed++;
+        }
+        digits=vr+(vr==vm || lastRemovedDigit>=5);
+    }
+    exponent=e10+removed;
+}
+
+inline char *writeDigits(char *out,quint64 value,int count)
+{
+    for(int i=count-1;i>=0;i--)
+    {
+        out[i]=char('0'+value%10);
+        value/=10;
+    }
+    return out+count;
+}
+}
+
+int FloatFormat::shortest(float value, char *out)
+{
+    quint32 bits;
+    memcpy(&bits,&value,sizeof(bits));
+    const bool negative=bits>>31;
+    const quint32 ieeeMantissa=bits&0x7fffff;
+    const quint32 ieeeExponent=(bits>>23)&0xff;
+    char *p=out;
+    if(ieeeExponent==0xff)
+    {
+        const char *text=ieeeMantissa ? "nan" : (negative ? "-inf" : "inf");
+        const int length=int(strlen(text));
+        memcpy(out,text,length);
+        return length;
+    }
+    if(negative)
+        *p++='-';
+    if(ieeeExponent==0 && ieeeMantissa==0)
+    {
+        *p++='0';
+        return int(p-out);
+    }
+
+    quint32 digits;
+    int exponent;
+    decimal(ieeeMantissa,ieeeExponent,digits,exponent);
+    const int length=digitCount(digits);
+    const int point=length+exponent;//позиция десятичной точки относительно первой цифры
+
+    if(point>0 && point<=9)
+    {
+        //обычная запись: 12.5, 1500
+        if(exponent>=0)
+        {
+            p=writeDigits(p,digits,length);
+            for(int i=0;i<exponent;i++)
+                *p++='0';
+        }
+        else
+        {
+            writeDigits(p,digits/KPow10[-exponent],point);
+            p+=point;
+            *p++='.';
+            p=writeDigits(p,digits%KPow10[-exponent],-exponent);
+        }
+    }
+    else if(point<=0 && point>-5)
+    {
+        //0.00125
+        *p++='0';
+        *p++='.';
+        for(int i=0;i<-point;i++)
+            *p++='0';
+        p=writeDigits(p,digits,length);
+    }
+    else
+    {
+        //1.25e-7
+        *p++=char('0'+digits/KPow10[length-1]);
+        if(length>1)
+        {
+            *p++='.';
+            p=writeDigits(p,digits%KPow10[length-1],length-1);
+        }
+        *p++='e';
+        int e=point-1;
+        if(e<0)
+        {
+            *p++='-';
+            e=-e;
+        }
+        if(e>=10)
+            *p++=char('0'+e/10);
+        *p++=char('0'+e%10);
+    }
+    return int(p-out);
+}
+
+int FloatFormat::fixed(double value, int decimals, char *out)
+{
+    const double magnitude=value<0 ? -value : value;
+    //NaN/inf и числа, не помещающиеся в целую часть, пишутся стандартным путём
+    if(!(magnitude<1e15) || decimals>15)
+        return snprintf(out,KMaxFixedLength,"%.17g",value);
+    //дробная часть выделяется точно, округляется только она
+    quint64 whole=quint64(magnitude);
+    quint64 fraction=quint64((magnitude-double(whole))*KPow10[decimals]+0.5);
+    if(fraction>=KPow10[decimals])
+    {
+        whole++;
+        fraction-=KPow10[decimals];
+    }
+    char *p=out;
+    if(value<0 && (whole || fraction))
+        *p++='-';
+    int length=1;
+    while(length<19 && whole>=KPow10[length])
+        length++;
+    p=writeDigits(p,whole,length);
+    if(decimals>0)
+    {
+        *p++='.';
+        p=writeDigits(p,fraction,decimals);
+    }
+    return int(p-out);
+}
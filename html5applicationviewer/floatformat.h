@@ -0,0 +1,28 @@
+#ifndef FLOATFORMAT_H
+#define FLOATFORMAT_H
+
+#include <QtGlobal>
+#include <cstring>
+
+//Быстрый перевод чисел в текст для выгрузки и моста в JS.
+//Пишут в переданный буфер и возвращают длину, без выделения памяти.
+//Нечисловые значения определяются по битам, а не по тексту
+namespace FloatFormat
+{
+const int KMaxShortestLength = 16;//"-1.17549435e-38"
+const int KMaxFixedLength = 32;
+
+//кратчайшая запись, из которой float восстанавливается без потерь (алгоритм Ryu)
+int shortest(float value,char *out);
+//фиксированное число знаков после точки; для очень больших значений - snprintf
+int fixed(double value,int decimals,char *out);
+
+inline bool isFinite(float value)
+{
+    quint32 bits;
+    memcpy(&bits,&value,sizeof(bits));
+    return (bits&0x7f800000u)!=0x7f800000u;
+}
+}
+
+#endif // FLOATFORMAT_H
@@ -0,0 +1,34 @@
+#include "framescheduler.h"
+
+FrameScheduler::FrameScheduler(QObject *parent)
+    : QObject(parent)
+    , m_pending(0)
+    , m_inFrame(false)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer,SIGNAL(timeout()),SLOT(fire()));
+}
+
+void FrameScheduler::request(int updates)
+{
+    m_pending|=updates;
+    if(m_timer.isActive() || m_inFrame)
+        return;
+    //после паузы кадр идёт сразу, но не раньше, чем обработаны уже пришедшие события
+    qint64 wait=m_sinceFrame.isValid() ? KFrameIntervalMs-m_sinceFrame.elapsed() : 0;
+    m_timer.start(int(qMax<qint64>(0,wait)));
+}
+
+void FrameScheduler::fire()
+{
+    int updates=m_pending;
+    m_pending=0;
+    m_inFrame=true;
+    if(updates)
+        emit frame(updates);
+    m_inFrame=false;
+    m_sinceFrame.start();
+    //запрошенное во время кадра рисуется в следующем
+    if(m_pending)
+        m_timer.start(KFrameIntervalMs);
+}
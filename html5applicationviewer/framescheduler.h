@@ -0,0 +1,36 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+//Слияние событий ввода по кадрам: панорамирование, масштаб и наведение только отмечают,
+//что изменилось (биты updates), а перерисовка выполняется не чаще раза за кадр
+//по последнему состоянию - промежуточные состояния отбрасываются.
+//Следующий кадр отсчитывается от конца предыдущего, чтобы тяжёлая отрисовка не вытесняла ввод
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    static const int KFrameIntervalMs = 16;
+
+    explicit FrameScheduler(QObject *parent = 0);
+
+    void request(int updates);
+    int pending() const {return m_pending;}
+
+signals:
+    void frame(int updates);
+
+private slots:
+    void fire();
+
+private:
+    QTimer m_timer;
+    QElapsedTimer m_sinceFrame;
+    int m_pending;
+    bool m_inFrame;
+};
+
+#endif // FRAMESCHEDULER_H
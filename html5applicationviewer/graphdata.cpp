@@ -1,5 +1,15 @@
 #include "graphdata.h"
+#include "floatformat.h"
 #include <QString>
+#include <QByteArray>
+#include <qnumeric.h>
+#include <algorithm>
+
+//столбец лога для каждого канала; -1 - вычисляемый
+static const int KChannelColumn[GraphData::ChannelCount]={
+    LogRangeReader::CurrentWheelAngle,LogRangeReader::DesiredWheelAngle,LogRangeReader::WheelPowerR,
+    LogRangeReader::WheelPowerL,LogRangeReader::PhysicsTimestep,LogRangeReader::ControlInterval,
+    LogRangeReader::LinePosition,-1};
 
 GraphData::GraphData()
 {
@@ -10,13 +20,7 @@ bool GraphData::createNew(QString name)
     if(findByName(name)!=-1)
         return 0;
 	file_name<<name;
-    current_wheel_angle<<"0";
-    desired_wheel_angle<<"0";
-    wheel_power_r<<"0";
-    wheel_power_l<<"0";
-    physics_timestep<<"0";
-    control_interval<<"0";
-    line_position<<"0";
+    runs.append(Run());
     return 1;
 }
 int GraphData::length()
@@ -24,7 +28,7 @@ int GraphData::length()
     return file_name.length();
 }
 int GraphData::findByName(QString name)
-{ 
+{
     for (int i = 0; i < file_name.length(); ++i)
 	{
 		if(file_name[i]==name)
@@ -32,115 +36,379 @@ int GraphData::findByName(QString name)
     }
     return -1;
 }
-void GraphData::addTo(QString name, QString current_wheel_angle_1, QString desired_wheel_angle_1, QString wheel_power_r_1, QString wheel_power_l_1, QString physics_timestep_1, QString control_interval_1, QString line_position_1)
-{
-	int i = findByName(name);
-    if ((current_wheel_angle_1=="nan")||(current_wheel_angle_1=="inf")||(current_wheel_angle_1=="-inf"))
-        current_wheel_angle_1="null";
-    if ((desired_wheel_angle_1=="nan")||(desired_wheel_angle_1=="inf")||(desired_wheel_angle_1=="-inf"))
-        desired_wheel_angle_1="null";
-    if ((wheel_power_r_1=="nan")||(wheel_power_r_1=="inf")||(wheel_power_r_1=="-inf"))
-        wheel_power_r_1="null";
-    if ((wheel_power_l_1=="nan")||(wheel_power_l_1=="inf")||(wheel_power_l_1=="-inf"))
-        wheel_power_l_1="null";
-    if ((physics_timestep_1=="nan")||(physics_timestep_1=="inf")||(physics_timestep_1=="-inf"))
-        physics_timestep_1="null";
-    if ((control_interval_1=="nan")||(control_interval_1=="inf")||(control_interval_1=="-inf"))
-        control_interval_1="null";
-    if ((line_position_1=="nan")||(line_position_1=="inf")||(line_position_1=="-inf")||(line_position_1=="-1"))
-        line_position_1="null";
-    current_wheel_angle[i]=current_wheel_angle[i]+", "+current_wheel_angle_1;
-    desired_wheel_angle[i]=desired_wheel_angle[i]+", "+desired_wheel_angle_1;
-    wheel_power_r[i]=wheel_power_r[i]+", "+wheel_power_r_1;
-    wheel_power_l[i]=wheel_power_l[i]+", "+wheel_power_l_1;
-    physics_timestep[i]=physics_timestep[i]+", "+physics_timestep_1;
-    control_interval[i]=control_interval[i]+", "+control_interval_1;
-    line_position[i]=line_position[i]+", "+line_position_1;
+void GraphData::addTo(QString name, const DataSet &dataset)
+{
+    addTo(findByName(name),&dataset,1);
+}
+void GraphData::addTo(int index, const DataSet *records, int count)
+{
+    Run &run=runs[index];
+    for(int i=0;i<count;i++)
+    {
+        const DataSet &dataset=records[i];
+        double t=0;
+        if(!run.time.isEmpty())
+        {
+            float dt=run.channels[PhysicsTimestep].last();
+            t=run.time.last();
+            if(qIsFinite(dt) && dt>0)
+                t+=dt;
+        }
+        run.time.append(t);
+        run.positionX.append(dataset.camera.p.x());
+        run.positionZ.append(dataset.camera.p.z());
+        run.channels[CurrentWheelAngle].append(dataset.current_wheel_angle);
+        run.channels[DesiredWheelAngle].append(dataset.desired_wheel_angle);
+        run.channels[WheelPowerR].append(dataset.wheel_power_r);
+        run.channels[WheelPowerL].append(dataset.wheel_power_l);
+        run.channels[PhysicsTimestep].append(dataset.physics_timestep);
+        run.channels[ControlInterval].append(dataset.control_interval);
+        //-1 означает потерю линии, на графике это разрыв
+        run.channels[LinePosition].append(dataset.line_position==-1 ? qQNaN() : float(dataset.line_position));
+        run.channels[TrackingError].append(dataset.desired_wheel_angle-dataset.current_wheel_angle);
+    }
+}
+bool GraphData::attach(QString name, QString fileName, int samplePoints)
+{
+    if(!createNew(name))
+        return false;
+    Run &run=runs.last();
+    run.source=QSharedPointer<LogRangeReader>(new LogRangeReader);
+    if(!run.source->open(fileName))
+    {
+        deleteByName(name);
+        return false;
+    }
+    //читается только выборка записей, время до первого графика не зависит от размера файла
+    const int count=run.source->recordCount();
+    const int stride=qMax(1,(count+samplePoints-1)/qMax(1,samplePoints));
+    run.overview=run.source->sample((1<<LogRangeReader::ColumnCount)-1,stride);
+    append(run,run.overview,0,run.overview.time.size());
+    run.windowDownsampled=run.overview.downsampled;
+    return true;
+}
+bool GraphData::attach(QString name, QString fileName, const LogRangeReader::Window &overview, const QVector<double> &timeIndex)
+{
+    if(!createNew(name))
+        return false;
+    Run &run=runs.last();
+    run.source=QSharedPointer<LogRangeReader>(new LogRangeReader);
+    if(!run.source->open(fileName) || timeIndex.size()!=run.source->recordCount())
+    {
+        deleteByName(name);
+        return false;
+    }
+    refine(runs.size()-1,overview,timeIndex);
+    return true;
+}
+bool GraphData::restore(QString name, const QVector<double> &time, const QVector<QVector<float> > &channels, const QVector<float> &positionX, const QVector<float> &positionZ)
+{
+    if(channels.size()!=ChannelCount || positionX.size()!=time.size() || positionZ.size()!=time.size())
+        return false;
+    for(int c=0;c<ChannelCount;c++)
+        if(channels[c].size()!=time.size())
+            return false;
+    if(!createNew(name))
+        return false;
+    Run &run=runs.last();
+    run.time=time;
+    run.positionX=positionX;
+    run.positionZ=positionZ;
+    for(int c=0;c<ChannelCount;c++)
+        run.channels[c]=channels[c];
+    return true;
+}
+const LogRangeReader::Window &GraphData::overview(int index) const
+{
+    return runs[index].overview;
+}
+void GraphData::refine(int index, const LogRangeReader::Window &overview, const QVector<double> &timeIndex)
+{
+    Run &run=runs[index];
+    if(run.source.isNull())
+        return;
+    if(!timeIndex.isEmpty())
+        run.source->setIndex(timeIndex);
+    run.overview=overview;
+    run.time.clear();
+    run.positionX.clear();
+    run.positionZ.clear();
+    for(int c=0;c<ChannelCount;c++)
+        run.channels[c].clear();
+    append(run,run.overview,0,run.overview.time.size());
+    run.derived.clear();
+    run.statistics.clear();
+    //подробное окно строится заново уже по новому обзору
+    run.windowBegin=run.windowEnd=qQNaN();
+    run.windowColumns=0;
+    run.windowDownsampled=run.overview.downsampled;
+}
+bool GraphData::isIndexed(int index) const
+{
+    const Run &run=runs[index];
+    return run.source.isNull() || run.source->isIndexed();
+}
+bool GraphData::isPartial(int index) const
+{
+    return !runs[index].source.isNull();
+}
+int GraphData::recordCount(int index) const
+{
+    const Run &run=runs[index];
+    return run.source.isNull() ? run.time.size() : run.source->recordCount();
+}
+bool GraphData::needsLoad(int index, const QList<int> &channels, double tBegin, double tEnd) const
+{
+    const Run &run=runs[index];
+    if(run.source.isNull() || !run.source->isIndexed())
+        return false;
+    //канал, отмеченный после чтения окна, в окне пуст - окно перечитывается с ним
+    bool overlaps=!qIsNaN(run.windowBegin) && tEnd>run.windowBegin && tBegin<run.windowEnd;
+    if(overlaps && (columnMask(channels)&~run.windowColumns)!=0)
+        return true;
+    if(!run.windowDownsampled)
+        return false;
+    //окно перечитывается, если вышли за него или приблизились настолько, что прореживание заметно
+    bool inside=!qIsNaN(run.windowBegin) && tBegin>=run.windowBegin && tEnd<=run.windowEnd;
+    return !inside || (run.windowEnd>run.windowBegin && tEnd-tBegin<0.5*(run.windowEnd-run.windowBegin));
+}
+QSharedPointer<LogRangeReader> GraphData::source(int index) const
+{
+    return runs[index].source;
+}
+void GraphData::load(int index, const LogRangeReader::Window &window, int columns, double tBegin, double tEnd)
+{
+    Run &run=runs[index];
+    if(run.source.isNull() || !run.source->isIndexed())
+        return;
+    const QVector<double> &t=run.overview.time;
+    int before=std::lower_bound(t.constBegin(),t.constEnd(),tBegin)-t.constBegin();
+    int after=std::upper_bound(t.constBegin(),t.constEnd(),tEnd)-t.constBegin();
+    run.time.clear();
+    run.positionX.clear();
+    run.positionZ.clear();
+    for(int c=0;c<ChannelCount;c++)
+        run.channels[c].clear();
+    //обзор вне окна сохраняется, чтобы навигатор графика видел весь прогон
+    append(run,run.overview,0,before);
+    append(run,window,0,window.time.size());
+    append(run,run.overview,after,t.size());
+    run.derived.clear();
+    run.statistics.clear();
+    run.windowBegin=tBegin;
+    run.windowEnd=tEnd;
+    run.windowDownsampled=window.downsampled;
+    run.windowColumns=columns;
+}
+int GraphData::columnMask(const QList<int> &channels)
+{
+    int columns=1<<LogRangeReader::PositionX | 1<<LogRangeReader::PositionZ;
+    for(int i=0;i<channels.size();i++)
+    {
+        int channel=channels[i];
+        if(channel>=0 && channel<ChannelCount && KChannelColumn[channel]>=0)
+            columns|=1<<KChannelColumn[channel];
+        else if(channel==TrackingError)
+            columns|=1<<LogRangeReader::CurrentWheelAngle | 1<<LogRangeReader::DesiredWheelAngle;
+        else
+            columns|=(1<<LogRangeReader::ColumnCount)-1;//выражение может ссылаться на любой канал
+    }
+    return columns;
+}
+GraphData::Source GraphData::snapshot(int index, const QList<int> &channels) const
+{
+    const Run &run=runs[index];
+    Source source;
+    source.name=file_name[index];
+    source.channels=channels;
+    //пока индекс строится, доступно только то, что уже в памяти
+    if(!run.source.isNull() && run.source->isIndexed())
+    {
+        source.reader=run.source;
+        return source;
+    }
+    source.time=run.time;
+    for(int k=0;k<channels.size();k++)
+        source.columns<<column(index,channels[k]);
+    return source;
+}
+QPair<int,int> GraphData::sourceRange(const Source &source, double tBegin, double tEnd)
+{
+    if(!source.reader.isNull())
+        return source.reader->recordRange(tBegin,tEnd);
+    const QVector<double> &t=source.time;
+    int begin=std::lower_bound(t.constBegin(),t.constEnd(),tBegin)-t.constBegin();
+    int end=std::upper_bound(t.constBegin()+begin,t.constEnd(),tEnd)-t.constBegin();
+    return qMakePair(begin,end);
+}
+void GraphData::readSource(const Source &source, int begin, int end, QVector<double> &time, QVector<QVector<float> > &columns)
+{
+    const QList<int> &channels=source.channels;
+    const int count=qMax(0,end-begin);
+    columns.resize(channels.size());
+    if(source.reader.isNull())
+    {
+        time=source.time.mid(begin,count);
+        for(int k=0;k<channels.size();k++)
+            columns[k]=source.columns[k].mid(begin,count);
+        return;
+    }
+    Run chunk;
+    append(chunk,source.reader->readRecords(columnMask(channels),begin,end),0,count);
+    time=chunk.time;
+    //производные каналы считаются по данным в памяти, для файла без полной загрузки их нет
+    for(int k=0;k<channels.size();k++)
+        columns[k]=channels[k]<ChannelCount ? chunk.channels[channels[k]] : QVector<float>(count,qQNaN());
+}
+void GraphData::append(Run &run, const LogRangeReader::Window &window, int begin, int end)
+{
+    if(end<=begin)
+        return;
+    const int count=end-begin;
+    run.time+=window.time.mid(begin,count);
+    const QVector<float> nan(count,qQNaN());
+    run.positionX+=window.columns[LogRangeReader::PositionX].isEmpty() ? nan : window.columns[LogRangeReader::PositionX].mid(begin,count);
+    run.positionZ+=window.columns[LogRangeReader::PositionZ].isEmpty() ? nan : window.columns[LogRangeReader::PositionZ].mid(begin,count);
+    for(int c=0;c<TrackingError;c++)
+    {
+        const QVector<float> &column=window.columns[KChannelColumn[c]];
+        run.channels[c]+=column.isEmpty() ? nan : column.mid(begin,count);
+    }
+    //в прореженном окне это разность огибающих, а не огибающая разности
+    const QVector<float> &current=window.columns[LogRangeReader::CurrentWheelAngle];
+    const QVector<float> &desired=window.columns[LogRangeReader::DesiredWheelAngle];
+    for(int i=begin;i<end;i++)
+        run.channels[TrackingError].append(current.isEmpty() || desired.isEmpty() ? qQNaN() : desired[i]-current[i]);
 }
 QString GraphData::get_name(int index)
 {
     return file_name[index];
 }
-QString GraphData::get_current_wheel_angle(QString name)
+int GraphData::addDerived(const ChannelExpression &expression)
 {
-    return get_current_wheel_angle(findByName(name));
+    derivedChannels.append(expression);
+    return channelCount()-1;
 }
-QString GraphData::get_current_wheel_angle(int index)
+int GraphData::channelCount() const
 {
-    return current_wheel_angle[index];
+    return ChannelCount+derivedChannels.size();
 }
-QString GraphData::get_desired_wheel_angle(QString name)
+bool GraphData::isDerivedCurrent(int index, int channel) const
 {
-    return get_desired_wheel_angle(findByName(name));
+    const Run &run=runs[index];
+    int k=channel-ChannelCount;
+    return k<run.derived.size() && run.derived[k].size()==run.time.size();
 }
-QString GraphData::get_desired_wheel_angle(int index)
+const QVector<float> &GraphData::column(int index, int channel) const
 {
-    return desired_wheel_angle[index];
+    if(channel<ChannelCount)
+        return runs[index].channels[channel];
+    const Run &run=runs[index];
+    int k=channel-ChannelCount;
+    if(run.derived.size()<derivedChannels.size())
+        run.derived.resize(derivedChannels.size());
+    if(!isDerivedCurrent(index,channel))
+        run.derived[k]=derivedChannels[k].evaluate(*this,index,0,run.time.size());
+    return run.derived[k];
 }
-QString GraphData::get_wheel_power_r(QString name)
+const QVector<double> &GraphData::time(int index) const
 {
-    return get_wheel_power_r(findByName(name));
+    return runs[index].time;
 }
-QString GraphData::get_wheel_power_r(int index)
+const QVector<float> &GraphData::positionX(int index) const
 {
-    return wheel_power_r[index];
+    return runs[index].positionX;
 }
-QString GraphData::get_wheel_power_l(QString name)
+const QVector<float> &GraphData::positionZ(int index) const
 {
-    return get_wheel_power_l(findByName(name));
+    return runs[index].positionZ;
 }
-QString GraphData::get_wheel_power_l(int index)
+QPair<int,int> GraphData::visibleRange(int index, double tBegin, double tEnd) const
 {
-    return wheel_power_l[index];
+    const QVector<double> &t=runs[index].time;
+    int begin=std::lower_bound(t.constBegin(),t.constEnd(),tBegin)-t.constBegin();
+    int end=std::upper_bound(t.constBegin()+begin,t.constEnd(),tEnd)-t.constBegin();
+    return qMakePair(begin,end);
 }
-QString GraphData::get_physics_timestep(QString name)
+int GraphData::nearestSample(int index, double t) const
 {
-    return get_physics_timestep(findByName(name));
+    const QVector<double> &time=runs[index].time;
+    if(time.isEmpty())
+        return -1;
+    int after=std::lower_bound(time.constBegin(),time.constEnd(),t)-time.constBegin();
+    if(after==time.size())
+        return after-1;
+    if(after>0 && t-time[after-1]<time[after]-t)
+        return after-1;
+    return after;
 }
-QString GraphData::get_physics_timestep(int index)
+ChannelStatistics::Result GraphData::statistics(int index, int channel, double tBegin, double tEnd) const
 {
-    return physics_timestep[index];
+    static const ChannelStatistics empty;
+    const QVector<float> &values=column(index,channel);
+    QPair<int,int> range=visibleRange(index,tBegin,tEnd);
+    return (hasStatistics(index,channel) ? runs[index].statistics[channel] : empty).query(values,range.first,range.second);
 }
-QString GraphData::get_control_interval(QString name)
+bool GraphData::hasStatistics(int index, int channel) const
 {
-    return get_control_interval(findByName(name));
+    const Run &run=runs[index];
+    return channel<run.statistics.size() && run.statistics[channel].size()==column(index,channel).size();
 }
-QString GraphData::get_control_interval(int index)
+void GraphData::setStatistics(int index, int channel, const QVector<float> &values, const ChannelStatistics &statistics)
 {
-    return control_interval[index];
+    Run &run=runs[index];
+    //копия разделяет данные со столбцом, пока тот не изменился
+    if(values.constData()!=column(index,channel).constData() || statistics.size()!=values.size())
+        return;
+    if(run.statistics.size()<channelCount())
+        run.statistics.resize(channelCount());
+    run.statistics[channel]=statistics;
 }
-QString GraphData::get_line_position(QString name)
+QString GraphData::get(int index,int count)
 {
-    return get_line_position(findByName(name));
+    if(count<0 || count>=channelCount())
+        return "-1";
+    return get(index,count,-qInf(),qInf());
 }
-QString GraphData::get_line_position(int index)
+QString GraphData::get(int index, int count, double tBegin, double tEnd)
 {
-    return line_position[index];
+    if(count<0 || count>=channelCount())
+        return "-1";
+    QPair<int,int> range=visibleRange(index,tBegin,tEnd);
+    const double *t=runs[index].time.constData()+range.first;
+    if(count<ChannelCount || isDerivedCurrent(index,count))
+        return format(t,column(index,count).constData()+range.first,range.second-range.first);
+    QVector<float> values=derivedChannels[count-ChannelCount].evaluate(*this,index,range.first,range.second);
+    return format(t,values.constData(),values.size());
 }
-QString GraphData::get(int index,int count)
+QString GraphData::format(const double *t, const float *y, int count)
 {
-    switch(count)
+    //одна строка на всю серию: текст пишется в заранее выделенный буфер без промежуточных QString
+    QByteArray buffer;
+    buffer.resize(count*(FloatFormat::KMaxFixedLength+FloatFormat::KMaxShortestLength+4));
+    char *out=buffer.data();
+    for(int i=0;i<count;i++)
     {
-    case 0:return current_wheel_angle[index];
-    case 1:return desired_wheel_angle[index];
-    case 2:return wheel_power_r[index];
-    case 3:return wheel_power_l[index];
-    case 4:return physics_timestep[index];
-    case 5:return control_interval[index];
-    case 6:return line_position[index];
-    default: return "-1";
+        if(i)
+            *out++=',';
+        *out++='[';
+        out+=FloatFormat::fixed(t[i],6,out);
+        *out++=',';
+        if(FloatFormat::isFinite(y[i]))
+            out+=FloatFormat::shortest(y[i],out);
+        else
+        {
+            memcpy(out,"null",4);
+            out+=4;
+        }
+        *out++=']';
     }
+    return QString::fromLatin1(buffer.constData(),int(out-buffer.constData()));
 }
 
 void GraphData::deleteByName(QString name)
 {
     int index=findByName(name);
-    current_wheel_angle.removeAt(index);
-    desired_wheel_angle.removeAt(index);
-    wheel_power_r.removeAt(index);
-    wheel_power_l.removeAt(index);
-    physics_timestep.removeAt(index);
-    control_interval.removeAt(index);
-    line_position.removeAt(index);
+    runs.remove(index);
     file_name.removeAt(index);
 }
@@ -2,42 +2,96 @@
 #define GRAPHDATA_H
 #include <QString>
 #include <QStringList>
+#include <QVector>
+#include <QPair>
+#include <QList>
+#include <QSharedPointer>
+#include <qnumeric.h>
+
+#include "common.h"
+#include "channelstatistics.h"
+#include "channelexpression.h"
+#include "lograngereader.h"
 
 class GraphData
 {
-
-    QStringList camera_pixels;
-    QStringList current_wheel_angle;
-    QStringList desired_wheel_angle;
-    QStringList wheel_power_r;
-    QStringList wheel_power_l;
-    QStringList physics_timestep;
-    QStringList control_interval;
-    QStringList line_position;
+public:
+    enum Channel{CurrentWheelAngle,DesiredWheelAngle,WheelPowerR,WheelPowerL,PhysicsTimestep,ControlInterval,LinePosition,TrackingError,ChannelCount};
+private:
+    struct Run
+    {
+        QVector<float> channels[ChannelCount];
+        QVector<double> time;//время начала каждого отсчёта (префиксная сумма physics_timestep)
+        QVector<float> positionX;//положение камеры, вид сверху (x,z)
+        QVector<float> positionZ;
+        mutable QVector<QVector<float> > derived;//производные каналы, вычисляются целиком только по требованию
+        QVector<ChannelStatistics> statistics;//строится в фоне по запросу StatisticsPanel
+        QSharedPointer<LogRangeReader> source;//большой файл: в памяти обзор и подробное окно
+        LogRangeReader::Window overview;
+        double windowBegin;
+        double windowEnd;
+        bool windowDownsampled;
+        int windowColumns;//столбцы, прочитанные в окно; остальные каналы в окне - NaN
+        Run() : windowBegin(qQNaN()), windowEnd(qQNaN()), windowDownsampled(false), windowColumns(0) {}
+    };
+    QVector<Run> runs;
     QStringList file_name;
-    int findByName(QString name);
+    QList<ChannelExpression> derivedChannels;
+    bool isDerivedCurrent(int index,int channel) const;
+    static void append(Run &run,const LogRangeReader::Window &window,int begin,int end);
 public:
     GraphData();
+    int findByName(QString name);
     bool createNew(QString name);
-    void addTo(QString name, QString current_wheel_angle, QString desired_wheel_angle, QString wheel_power_r, QString wheel_power_l, QString physics_timestep, QString control_interval, QString line_position);
+    void addTo(QString name, const DataSet &dataset);
+    void addTo(int index,const DataSet *records,int count);//пачка записей без поиска прогона по имени
+    bool attach(QString name,QString fileName,int samplePoints);//без полного чтения файла
+    //восстановление из снимка сессии, без чтения записей: большой лог - обзор и готовый индекс времени
+    bool attach(QString name,QString fileName,const LogRangeReader::Window &overview,const QVector<double> &timeIndex);
+    bool restore(QString name,const QVector<double> &time,const QVector<QVector<float> > &channels,const QVector<float> &positionX,const QVector<float> &positionZ);
+    const LogRangeReader::Window &overview(int index) const;
+    //замена обзора более подробным; с индексом времени становится доступно чтение окон
+    void refine(int index,const LogRangeReader::Window &overview,const QVector<double> &timeIndex);
+    bool isPartial(int index) const;
+    bool isIndexed(int index) const;
+    int recordCount(int index) const;//записей в файле, а не отсчётов в памяти
+    bool needsLoad(int index,const QList<int> &channels,double tBegin,double tEnd) const;
+    //окно читается из source в фоне, здесь только подставляется вместо обзора
+    QSharedPointer<LogRangeReader> source(int index) const;
+    void load(int index,const LogRangeReader::Window &window,int columns,double tBegin,double tEnd);
+    static int columnMask(const QList<int> &channels);
+    //полные данные прогона без прореживания: из памяти или, для частично загруженных, из файла.
+    //Снимок берётся в потоке интерфейса, читать по нему можно из фоновой задачи
+    struct Source
+    {
+        QString name;
+        QList<int> channels;
+        QSharedPointer<LogRangeReader> reader;//проиндексированный файл
+        QVector<double> time;//иначе - данные в памяти, разделяемые без копирования
+        QVector<QVector<float> > columns;
+    };
+    Source snapshot(int index,const QList<int> &channels) const;
+    static QPair<int,int> sourceRange(const Source &source,double tBegin,double tEnd);
+    static void readSource(const Source &source,int begin,int end,QVector<double> &time,QVector<QVector<float> > &columns);
     int length();
     QString get_name(int index);
-    QString get_current_wheel_angle(QString name);
-    QString get_current_wheel_angle(int index);
-    QString get_desired_wheel_angle(QString name);
-    QString get_desired_wheel_angle(int index);
-    QString get_wheel_power_r(QString name);
-    QString get_wheel_power_r(int index);
-    QString get_wheel_power_l(QString name);
-    QString get_wheel_power_l(int index);
-    QString get_physics_timestep(QString name);
-    QString get_physics_timestep(int index);
-    QString get_control_interval(QString name);
-    QString get_control_interval(int index);
-    QString get_line_position(QString name);
-    QString get_line_position(int index);
+    int addDerived(const ChannelExpression &expression);
+    int channelCount() const;
+    const QVector<float> &column(int index,int channel) const;
+    const QVector<double> &time(int index) const;
+    const QVector<float> &positionX(int index) const;
+    const QVector<float> &positionZ(int index) const;
+    QPair<int,int> visibleRange(int index,double tBegin,double tEnd) const;
+    int nearestSample(int index,double t) const;//-1 - прогон пуст
+    //пока индекс канала не построен (setStatistics), результат пустой: count==0
+    ChannelStatistics::Result statistics(int index,int channel,double tBegin,double tEnd) const;
+    bool hasStatistics(int index,int channel) const;
+    //values - копия столбца, по которой строился индекс; изменённый с тех пор столбец индекс не примет
+    void setStatistics(int index,int channel,const QVector<float> &values,const ChannelStatistics &statistics);
     QString get(int index,int count);
+    QString get(int index,int count,double tBegin,double tEnd);
     void deleteByName(QString name);
+    static QString format(const double *t,const float *y,int count);
 };
 
 #endif // GRAPHDATA_H
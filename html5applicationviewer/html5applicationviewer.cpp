@@ -9,8 +9,43 @@
 #include <QGraphicsLinearLayout>
 #include <QGraphicsWebView>
 #include <QWebFrame>
+#include <QInputDialog>
+#include <QMessageBox>
+#include <QTabWidget>
+#include <QLineEdit>
+#include <qnumeric.h>
+#include <algorithm>
 #include "logger.h"
 #include "extendedlistitem.h"
+#include "floatformat.h"
+#include "sessionsnapshot.h"
+
+static const int KMaxListedEvents = 1000;//на прогон, в списке и на графике
+static const qint64 KRangeLoadThreshold = 64*1024*1024;//файлы больше читаются окнами
+static const int KWindowPoints = 20000;
+static const int KSamplePoints = 1000;//первая выборка большого лога
+static const int KOverviewPoints = 20000;
+static const int KFanGridPoints = 1000;//узлов сетки сводки процентилей
+
+//строка как литерал JavaScript: в именах файлов и выражений бывают кавычки и обратная косая черта
+static QString jsString(const QString &text)
+{
+  QString result;
+  result.reserve(text.size()+2);
+  result+='\'';
+  for(int i=0;i<text.size();i++)
+  {
+    const ushort c=text[i].unicode();
+    if(c=='\\' || c=='\'' || c=='"')
+      result+='\\';
+    if(c<0x20 || c==0x2028 || c==0x2029 || c=='<')
+      result+=QString("\\u%1").arg(c,4,16,QChar('0'));
+    else
+      result+=text[i];
+  }
+  result+='\'';
+  return result;
+}
 
 #ifdef TOUCH_OPTIMIZED_NAVIGATION
 #include <QTimer>
@@ -895,12 +930,16 @@ void WebTouchNavigation::generateMouseEvent(const WebTouchEvent &touchEvent)
 
     public slots:
     void quit();
+    void setExtremes(double min, double max);
+    void setHoverTime(double t);
 
     private slots:
     void addToJavaScript();
 
     signals:
     void quitRequested();
+    void extremesChanged(double min, double max);
+    void hoverTimeChanged(double t);
 
   public:
     QGraphicsWebView *m_webView;
@@ -961,6 +1000,16 @@ void Html5ApplicationViewerPrivate::quit()
   emit quitRequested();
 }
 
+void Html5ApplicationViewerPrivate::setExtremes(double min, double max)
+{
+  emit extremesChanged(min, max);
+}
+
+void Html5ApplicationViewerPrivate::setHoverTime(double t)
+{
+  emit hoverTimeChanged(t);
+}
+
 void Html5ApplicationViewerPrivate::addToJavaScript()
 {
   m_webView->page()->mainFrame()->addToJavaScriptWindowObject("Qt", this);
@@ -968,6 +1017,14 @@ void Html5ApplicationViewerPrivate::addToJavaScript()
 
 Html5ApplicationViewer::Html5ApplicationViewer(QWidget *parent)
 : QWidget(parent)
+, comparison(data)
+, fan(data)
+, events(data)
+, loader(data,KSamplePoints,KOverviewPoints)
+, live(data)
+, exporter(data)
+, hoverTime(0)
+, cursorTime(0)
 {
 
   QHBoxLayout *hbox = new QHBoxLayout;
@@ -975,7 +1032,7 @@ Html5ApplicationViewer::Html5ApplicationViewer(QWidget *parent)
   QGridLayout *layout_RB = new QGridLayout;
   listOfGraphs=new QListWidget;
   view=new Html5ApplicationViewerPrivate*[0];
-  listOfGraphNames<<"Current Wheel Angle"<<"Desired Wheel Angle"<<"Wheel Power R"<<"Wheel Power L"<<"Physics Timestep"<<"Control Interval"<<"Line Position";
+  listOfGraphNames<<"Current Wheel Angle"<<"Desired Wheel Angle"<<"Wheel Power R"<<"Wheel Power L"<<"Physics Timestep"<<"Control Interval"<<"Line Position"<<"Tracking Error";
   ExtendedListItem **listOfGraph=new ExtendedListItem*[listOfGraphNames.length()];
   for(int i=0;i<listOfGraphNames.length();i++)
   {
@@ -985,8 +1042,62 @@ Html5ApplicationViewer::Html5ApplicationViewer(QWidget *parent)
   connect(listOfGraphs,SIGNAL(itemClicked(QListWidgetItem*)),SLOT(selectItem(QListWidgetItem*)));
   listOfGraphs->show();
   layout_RB->addWidget(listOfGraphs,0,0);
+  QPushButton *button_AddChannel=new QPushButton("Add channel");
+  connect(button_AddChannel,SIGNAL(clicked()),SLOT(addDerivedChannel()));
+  layout_RB->addWidget(button_AddChannel,1,0);
+  comboReference=new QComboBox;
+  comboReference->addItem("No comparison");
+  connect(comboReference,SIGNAL(activated(int)),SLOT(comparisonChanged()));
+  layout_RB->addWidget(comboReference,2,0);
+  comboComparisonMode=new QComboBox;
+  comboComparisonMode->addItem("Difference");
+  comboComparisonMode->addItem("Absolute error");
+  connect(comboComparisonMode,SIGNAL(activated(int)),SLOT(comparisonChanged()));
+  layout_RB->addWidget(comboComparisonMode,3,0);
+  comboOverlay=new QComboBox;
+  comboOverlay->addItem("All runs");
+  comboOverlay->addItem("Percentile fan");
+  connect(comboOverlay,SIGNAL(activated(int)),SLOT(show1()));
+  layout_RB->addWidget(comboOverlay,4,0);
+  QPushButton *button_Spectrum=new QPushButton("Spectrum");
+  connect(button_Spectrum,SIGNAL(clicked()),SLOT(showSpectrum()));
+  layout_RB->addWidget(button_Spectrum,5,0);
+  spectrumView=new SpectrumView(data,this);
+  QPushButton *button_Trajectory=new QPushButton("Trajectory");
+  connect(button_Trajectory,SIGNAL(clicked()),SLOT(showTrajectory()));
+  layout_RB->addWidget(button_Trajectory,6,0);
+  trajectoryView=new TrajectoryView(data,this);
+  connect(trajectoryView,SIGNAL(timeHovered(double)),SLOT(setChartCursor(double)));
+  QPushButton *button_Density=new QPushButton("Density");
+  connect(button_Density,SIGNAL(clicked()),SLOT(showDensity()));
+  layout_RB->addWidget(button_Density,7,0);
+  densityView=new DensityView(data,this);
+  QPushButton *button_Replay=new QPushButton("Replay");
+  connect(button_Replay,SIGNAL(clicked()),SLOT(showReplay()));
+  layout_RB->addWidget(button_Replay,8,0);
+  replayView=new ReplayView(this);
+  connect(replayView,SIGNAL(timeChanged(double)),SLOT(replayTimeChanged(double)));
+  QPushButton *button_Threshold=new QPushButton("Add threshold");
+  connect(button_Threshold,SIGNAL(clicked()),SLOT(addThreshold()));
+  layout_RB->addWidget(button_Threshold,9,0);
+  connect(&events,SIGNAL(changed()),SLOT(eventsChanged()));
+  connect(&comparison,SIGNAL(changed()),SLOT(show1()));
+  connect(&fan,SIGNAL(changed()),SLOT(show1()));
+  connect(&frames,SIGNAL(frame(int)),SLOT(renderFrame(int)));
+  connect(&loader,SIGNAL(loaded(QString,Logger::DamageReport)),SLOT(runLoaded(QString,Logger::DamageReport)));
+  connect(&loader,SIGNAL(refined(QString,bool)),SLOT(runRefined(QString,bool)));
+  connect(&loader,SIGNAL(windowLoaded(QString)),SLOT(windowLoaded(QString)));
+  connect(&loader,SIGNAL(damaged(QString,QString)),SLOT(runDamaged(QString,QString)));
+  connect(&live,SIGNAL(started(QString)),SLOT(liveStarted(QString)));
+  connect(&live,SIGNAL(appended(QString,int)),SLOT(liveAppended(QString,int)));
+  connect(&live,SIGNAL(finished(QString)),SLOT(liveFinished(QString)));
+  button_Export=new QPushButton("Export data");
+  connect(button_Export,SIGNAL(clicked()),SLOT(exportData()));
+  connect(&exporter,SIGNAL(progress(int)),SLOT(exportProgress(int)));
+  connect(&exporter,SIGNAL(finished(bool)),SLOT(exportFinished(bool)));
+  layout_RB->addWidget(button_Export,10,0);
   button_Save=new QPushButton("Save image");
-  layout_RB->addWidget(button_Save,1,0);
+  layout_RB->addWidget(button_Save,11,0);
   connect(button_Save,SIGNAL(clicked()),SLOT(saveImages()));
   right_bottom->setLayout(layout_RB);
   QFrame *right_top = new QFrame(this);
@@ -995,12 +1106,55 @@ Html5ApplicationViewer::Html5ApplicationViewer(QWidget *parent)
   QPushButton *button_1=new QPushButton("Open Folder");
   connect(button_1,SIGNAL(clicked()),SLOT(openFolder()));
   QGridLayout *layout_RT = new QGridLayout;
-  listOfOpenedFiles = new QListWidget();
-  connect(listOfOpenedFiles,SIGNAL(itemClicked(QListWidgetItem*)),SLOT(selectItem(QListWidgetItem*)));
-  listOfOpenedFiles->show();
+  fileModel=new FileListModel(this);
+  connect(fileModel,SIGNAL(checkChanged(int,bool)),SLOT(selectItemToShow(int,bool)));
+  fileProxy=new QSortFilterProxyModel(this);
+  fileProxy->setSourceModel(fileModel);
+  fileProxy->setFilterCaseSensitivity(Qt::CaseInsensitive);
+  fileProxy->setDynamicSortFilter(false);
+  listOfOpenedFiles = new QListView();
+  listOfOpenedFiles->setModel(fileProxy);
+  listOfOpenedFiles->setUniformItemSizes(true);//высота строк не пересчитывается для каждого файла
+  listOfOpenedFiles->setSelectionMode(QAbstractItemView::NoSelection);
+  FileListDelegate *fileDelegate=new FileListDelegate(listOfOpenedFiles);
+  connect(fileDelegate,SIGNAL(deleteRequested(QModelIndex)),SLOT(deleteItem(QModelIndex)));
+  listOfOpenedFiles->setItemDelegate(fileDelegate);
+  listOfOpenedFiles->setMouseTracking(true);
+  connect(listOfOpenedFiles,SIGNAL(clicked(QModelIndex)),SLOT(fileClicked(QModelIndex)));
+  connect(listOfOpenedFiles,SIGNAL(entered(QModelIndex)),SLOT(fileHovered(QModelIndex)));
+  connect(listOfOpenedFiles,SIGNAL(viewportEntered()),SLOT(fileUnhovered()));
+  QLineEdit *fileFilter=new QLineEdit;
+  fileFilter->setPlaceholderText("Filter");
+  connect(fileFilter,SIGNAL(textChanged(QString)),fileProxy,SLOT(setFilterWildcard(QString)));
+  QComboBox *fileSort=new QComboBox;
+  fileSort->addItem("Added");
+  fileSort->addItem("Name");
+  fileSort->addItem("Size");
+  fileSort->addItem("Records");
+  fileSort->addItem("Date");
+  connect(fileSort,SIGNAL(activated(int)),SLOT(sortFiles(int)));
   layout_RT->addWidget(button_0,0,0);
   layout_RT->addWidget(button_1,0,1);
-  layout_RT->addWidget(listOfOpenedFiles,1,0,1,0);
+  layout_RT->addWidget(fileFilter,1,0);
+  layout_RT->addWidget(fileSort,1,1);
+  layout_RT->addWidget(listOfOpenedFiles,2,0,1,0);
+  QPushButton *button_Find=new QPushButton("Find runs");
+  connect(button_Find,SIGNAL(clicked()),SLOT(findRuns()));
+  layout_RT->addWidget(button_Find,3,0,1,2);
+  QPushButton *button_SaveSession=new QPushButton("Save session");
+  connect(button_SaveSession,SIGNAL(clicked()),SLOT(saveSession()));
+  layout_RT->addWidget(button_SaveSession,4,0);
+  QPushButton *button_OpenSession=new QPushButton("Open session");
+  connect(button_OpenSession,SIGNAL(clicked()),SLOT(openSession()));
+  layout_RT->addWidget(button_OpenSession,4,1);
+  QPushButton *button_Live=new QPushButton("Live input");
+  button_Live->setCheckable(true);
+  connect(button_Live,SIGNAL(toggled(bool)),SLOT(toggleLive(bool)));
+  layout_RT->addWidget(button_Live,5,0);
+  liveStatus=new QLabel;
+  layout_RT->addWidget(liveStatus,5,1);
+  catalog.load();
+  connect(&catalog,SIGNAL(indexed(QString,int)),SLOT(folderIndexed(QString)));
   right_top->setLayout(layout_RT);
   QSplitter *splitter1 = new QSplitter(Qt::Vertical, this);
   right_top->setMaximumWidth(190);
@@ -1008,18 +1162,47 @@ Html5ApplicationViewer::Html5ApplicationViewer(QWidget *parent)
   splitter1->addWidget(right_top);
   splitter1->addWidget(right_bottom);
   frameWithGraphs = new QFrame(this);
+  visibleBegin=-qInf();
+  visibleEnd=qInf();
+  statisticsPanel=new StatisticsPanel(this);
+  connect(statisticsPanel,SIGNAL(indexed()),SLOT(updateStatistics()));
+  listOfEvents=new QListWidget;
+  connect(listOfEvents,SIGNAL(itemClicked(QListWidgetItem*)),SLOT(jumpToEvent(QListWidgetItem*)));
+  QTabWidget *bottomTabs=new QTabWidget(this);
+  bottomTabs->addTab(statisticsPanel,"Statistics");
+  bottomTabs->addTab(listOfEvents,"Events");
   redivisionGraph(0);
+  QSplitter *splitter4 = new QSplitter(Qt::Vertical, this);
+  splitter4->addWidget(frameWithGraphs);
+  splitter4->addWidget(bottomTabs);
+  splitter4->setStretchFactor(0,3);
   QSplitter *splitter2 = new QSplitter(Qt::Horizontal, this);
-  splitter2->addWidget(frameWithGraphs);
+  splitter2->addWidget(splitter4);
   splitter2->addWidget(splitter1);
   hbox->addWidget(splitter2);
   setLayout(hbox);
   layout_RT->setMargin(0);
   layout_RB->setMargin(0);
 }
-void Html5ApplicationViewer::deleteItem()
+void Html5ApplicationViewer::deleteItem(const QModelIndex &index)
+{
+  int row=fileProxy->mapToSource(index).row();
+  //выгрузка прогона идёт через снятие флажка
+  if(fileModel->entry(row).checked)
+    fileModel->setData(fileModel->index(row),Qt::Unchecked,Qt::CheckStateRole);
+  fileModel->removeFile(row);
+}
+
+void Html5ApplicationViewer::sortFiles(int column)
 {
-  delete sender();
+  static const int roles[]={-1,Qt::DisplayRole,FileListModel::SizeRole,FileListModel::RecordsRole,FileListModel::ModifiedRole};
+  if(roles[column]<0)
+  {
+    fileProxy->sort(-1);
+    return;
+  }
+  fileProxy->setSortRole(roles[column]);
+  fileProxy->sort(0,column==1 ? Qt::AscendingOrder : Qt::DescendingOrder);
 }
 void Html5ApplicationViewer::selectItem(QListWidgetItem *listWidgetItem)
 {
@@ -1032,17 +1215,57 @@ void Html5ApplicationViewer::openFolder()
   QString fileName=QFileDialog::getExistingDirectory(this,tr("Open Directory"),lastPatch,QFileDialog::ShowDirsOnly|QFileDialog::DontResolveSymlinks);
   if (fileName.length()>0)
   {
-    QDir dir(fileName);
-    QStringList files=dir.entryList(QStringList("*.dat"),QDir::Files|QDir::NoSymLinks);
-    if(files.length()>0)
-    {
-      lastPatch=fileName;
-      for(int j=0;j<files.length();j++)
-      {
-        addFileToList(fileName+"/"+files[j]);
-      }
-    }
+    lastPatch=fileName;
+    //каталог обходится рекурсивно в фоне, файлы попадут в список в folderIndexed
+    catalog.index(fileName);
+  }
+}
+
+void Html5ApplicationViewer::folderIndexed(const QString &root)
+{
+  addCatalogEntries(catalog.query(root+"/*"),root);
+}
+
+void Html5ApplicationViewer::findRuns()
+{
+  bool ok;
+  QString pattern=QInputDialog::getText(this,tr("Find runs"),tr("Path pattern (e.g. */2014-05-*/seed*/*.dat):"),QLineEdit::Normal,"*",&ok);
+  if(!ok || pattern.isEmpty())
+    return;
+  int minSize=QInputDialog::getInt(this,tr("Find runs"),tr("Minimum size, MB:"),0,0,1<<20,1,&ok);
+  if(!ok)
+    return;
+  QVector<LogCatalog::Entry> entries=catalog.query(pattern,qint64(minSize)*1024*1024);
+  if(entries.isEmpty())
+  {
+    QMessageBox::information(this,tr("Find runs"),tr("No runs in the catalog match (%1 files indexed).").arg(catalog.size()));
+    return;
+  }
+  //имена прогонов - пути от общего для всех найденных каталога
+  QString base=QFileInfo(entries.first().path).absolutePath();
+  for(int i=1;i<entries.size();i++)
+    while(!entries[i].path.startsWith(base+"/") && base.contains('/'))
+      base=base.left(base.lastIndexOf('/'));
+  addCatalogEntries(entries,base);
+}
+
+void Html5ApplicationViewer::addCatalogEntries(const QVector<LogCatalog::Entry> &found,const QString &root)
+{
+  QDir dir(root);
+  QVector<FileListModel::Entry> entries;
+  entries.reserve(found.size());
+  for(int j=0;j<found.size();j++)
+  {
+    FileListModel::Entry entry;
+    entry.path=found[j].path;
+    entry.label=dir.relativeFilePath(found[j].path);
+    entry.size=found[j].size;
+    entry.modified=found[j].modified;
+    entry.records=found[j].records;
+    entry.checked=false;
+    entries.append(entry);
   }
+  fileModel->addFiles(entries);
 }
 
 void Html5ApplicationViewer::redivisionGraph(int count)
@@ -1077,6 +1300,8 @@ void Html5ApplicationViewer::redivisionGraph(int count)
     view[i]->m_webView->page()->mainFrame()->evaluateJavaScript("document.write(\""+QString::number(i)+"\")");
 
     connect(view[i]->m_webView,SIGNAL(loadFinished(bool)),SLOT(show1()));
+    connect(view[i],SIGNAL(extremesChanged(double,double)),SLOT(visibleRangeChanged(double,double)));
+    connect(view[i],SIGNAL(hoverTimeChanged(double)),SLOT(chartHovered(double)));
     load(i,"html/index.html");
   }
   if (count>0)
@@ -1091,9 +1316,7 @@ void Html5ApplicationViewer::redivisionGraph(int count)
 
 void Html5ApplicationViewer::addFileToList(QString fileName)
 {
-  ExtendedListItem *item=new ExtendedListItem(listOfOpenedFiles,fileName);
-  connect(item,SIGNAL(buttonClicked()),SLOT(deleteItem()));
-  connect(item,SIGNAL(checkBoxChanged(int)),SLOT(selectItemToShow(int)));
+  fileModel->addFile(fileName);
 }
 
 void Html5ApplicationViewer::openFile()
@@ -1106,40 +1329,176 @@ void Html5ApplicationViewer::openFile()
   }
 }
 
-void Html5ApplicationViewer::selectItemToShow(int k)
+void Html5ApplicationViewer::selectItemToShow(int row,bool checked)
 {
-  int j;
-
-  if(k){
-    qDebug()<<k;
-    for(int i=0;i<listOfOpenedFiles->count();i++)
+  const FileListModel::Entry &item=fileModel->entry(row);
+  if(checked)
+  {
+    //чтение идёт в фоне; большой файл сразу показывается выборкой и уточняется
+    loader.start(item.label,item.path,item.size>KRangeLoadThreshold);
+  }
+  else
+  {
+    //снятый флажок отменяет и ещё не законченную загрузку
+    loader.cancel(item.label);
+    if(data.findByName(item.label)!=-1)
     {
-        ExtendedListItem* item=qobject_cast<ExtendedListItem*>(listOfOpenedFiles->itemWidget(listOfOpenedFiles->item(i)));
-     if(item->isChecked())
-     {
-       Logger l;
-       DataSet myDataSet;
-       l.setFileName(item->getFileSrc());
-
-       if(data.createNew(item->getLabelText()))
-       {
-        l.beginRead();
-        for(j=0;l.canRead();j++)
-        {
-          l>>myDataSet;
-          data.addTo(item->getLabelText(),QString::number(myDataSet.current_wheel_angle,'f'), QString::number(myDataSet.desired_wheel_angle,'f'),QString::number(myDataSet.wheel_power_r,'f'),QString::number(myDataSet.wheel_power_l,'f'),QString::number(myDataSet.physics_timestep,'f'),QString::number(myDataSet.control_interval,'f'),QString::number(myDataSet.line_position));
-        }      
-        l.endRead();
-      }
+      comparison.invalidate(item.label);
+      events.invalidate(item.label);
+      spectrumView->invalidate(item.label);
+      data.deleteByName(item.label);
     }
   }
+  updateReferenceList();
+  show1();
+}
+void Html5ApplicationViewer::runLoaded(const QString &run, const Logger::DamageReport &damage)
+{
+  events.scan(run);
+  updateReferenceList();
+  show1();
+  if(!damage.isClean())
+    reportDamage(run,damage);
+}
+
+void Html5ApplicationViewer::runRefined(const QString &run, bool final)
+{
+  int index=data.findByName(run);
+  if(index==-1)
+    return;
+  comparison.invalidate(run);
+  //события по выборке были бы неточны, они ищутся один раз по полному обзору
+  if(final)
+    events.scan(run);
+  if(comparison.isActive() || fanActive())
+  {
+    show1();
+    return;
+  }
+  //ряды заменяются на месте, масштаб графика не сбрасывается
+  QList<int> channels=checkedChannels();
+  for(int k=0;k<channels.size();k++)
+    webView(k)->page()->mainFrame()->evaluateJavaScript("setSeriesData("+jsString(run)+",["+data.get(index,channels[k])+"]);");
+  if(final)
+    loadVisibleWindow();
+  updateStatistics();
+  trajectoryView->dataChanged();
+}
+
+void Html5ApplicationViewer::runDamaged(const QString &run, const QString &fileName)
+{
+  comparison.invalidate(run);
+  events.invalidate(run);
+  spectrumView->invalidate(run);
+  data.deleteByName(run);
+  loader.start(run,fileName,false);
+  updateReferenceList();
+  show1();
+}
+
+void Html5ApplicationViewer::windowLoaded(const QString &run)
+{
+  int index=data.findByName(run);
+  if(index==-1 || comparison.isActive() || fanActive())
+    return;
+  comparison.invalidate(run);
+  QList<int> channels=checkedChannels();
+  for(int k=0;k<channels.size();k++)
+    webView(k)->page()->mainFrame()->evaluateJavaScript("setSeriesData("+jsString(run)+",["+data.get(index,channels[k])+"]);");
+  updateStatistics();
+}
+
+void Html5ApplicationViewer::toggleLive(bool on)
+{
+  if(on)
+  {
+    if(!live.listen())
+    {
+      QMessageBox::warning(this,tr("Live input"),tr("Cannot listen on %1: %2").arg(LiveStream::DefaultServerName).arg(live.errorString()));
+      ((QPushButton*)sender())->setChecked(false);
+      return;
+    }
+    liveStatus->setText(tr("Listening on %1").arg(LiveStream::DefaultServerName));
+    return;
   }
+  live.stop();
+  liveStatus->clear();
+  QStringList runs=live.runs();
+  for(int i=0;i<runs.size();i++)
+    if(data.findByName(runs[i])!=-1)
+    {
+      comparison.invalidate(runs[i]);
+      events.invalidate(runs[i]);
+      spectrumView->invalidate(runs[i]);
+      data.deleteByName(runs[i]);
+    }
+  updateReferenceList();
+  show1();
+}
+
+void Html5ApplicationViewer::liveStarted(const QString &run)
+{
+  //переподключение под тем же именем заменило прежний прогон
+  comparison.invalidate(run);
+  events.invalidate(run);
+  spectrumView->invalidate(run);
+  updateReferenceList();
+  liveStatus->setText(tr("%1 connected").arg(run));
+}
+
+void Html5ApplicationViewer::liveAppended(const QString &run, int first)
+{
+  int index=data.findByName(run);
+  if(index==-1)
+    return;
+  comparison.invalidate(run);
+  //первая пачка создаёт ряды; в сравнении и сводке ряды пересчитываются целиком
+  if(first==0 || comparison.isActive() || fanActive())
+    show1();
   else
   {
-      data.deleteByName(((ExtendedListItem*)sender())->getLabelText());
-      ((ExtendedListItem*)sender())->setClearColorOfCheckBox();
-  }  
+    //на графики уходят только новые отсчёты, масштаб не сбрасывается
+    const QVector<double> &time=data.time(index);
+    QList<int> channels=checkedChannels();
+    for(int k=0;k<channels.size();k++)
+    {
+      const QVector<float> &values=data.column(index,channels[k]);
+      webView(k)->page()->mainFrame()->evaluateJavaScript("appendSeriesData("+jsString(run)+",["+GraphData::format(time.constData()+first,values.constData()+first,time.size()-first)+"]);");
+    }
+    updateStatistics();
+    trajectoryView->dataChanged();
+  }
+  LiveIngest::Stats stats=live.stats(run);
+  QString text=tr("%1: %2 rec/s, latency %3 ms (mean %4, max %5)").arg(run).arg(stats.rate,0,'f',0)
+    .arg(stats.latency,0,'f',1).arg(stats.latencyMean,0,'f',1).arg(stats.latencyMax,0,'f',1);
+  //кольцо в разделяемой памяти не ждёт просмотрщика, отставшее теряется
+  if(stats.dropped>0)
+    text+=tr(", %1 dropped").arg(stats.dropped);
+  liveStatus->setText(text);
+}
+
+void Html5ApplicationViewer::liveFinished(const QString &run)
+{
+  if(data.findByName(run)==-1)
+    return;
+  //события ищутся один раз по завершённому прогону, как после чтения файла
+  events.scan(run);
   show1();
+  LiveIngest::Stats stats=live.stats(run);
+  liveStatus->setText(tr("%1 disconnected, %2 records").arg(run).arg(stats.records));
+}
+
+void Html5ApplicationViewer::reportDamage(const QString &label, const Logger::DamageReport &damage)
+{
+  QString text=tr("%1 is damaged. %2 records were recovered.").arg(label).arg(damage.records);
+  if(damage.headerGuessed)
+    text+="\n"+tr("The header is unreadable, the format version was guessed from the records.");
+  if(!damage.regions.isEmpty())
+    text+="\n"+tr("%1 bytes skipped in %2 damaged regions, the first at offset %3.")
+      .arg(damage.skippedBytes).arg(damage.regions.size()).arg(damage.regions.first().first);
+  if(damage.truncatedBytes>0)
+    text+="\n"+tr("The last record is incomplete (%1 bytes).").arg(damage.truncatedBytes);
+  QMessageBox::warning(this,tr("Damaged log"),text);
 }
 void Html5ApplicationViewer::show1()
 {
@@ -1152,6 +1511,11 @@ void Html5ApplicationViewer::show1()
         }
     }
 
+  comparison.compute(checkedChannels());
+  //сотни прогонов не рисуются по отдельности: в каждом узле общей сетки - процентили по прогонам
+  bool fanMode=fanActive();
+  if(fanMode)
+    fan.compute(checkedChannels(),KFanGridPoints);
   for(int i=0;i<data.length();i++)
   {
       QString color="#000";
@@ -1163,26 +1527,58 @@ void Html5ApplicationViewer::show1()
           if(color[j]=='1')
               color[j]='a';
       }
-      for (int j = 0; j <listOfOpenedFiles->count(); ++j) {
-          if(data.get_name(i)==((ExtendedListItem*)listOfOpenedFiles->itemWidget(listOfOpenedFiles->item(j)))->getLabelText())
-            {
-              ((ExtendedListItem*)listOfOpenedFiles->itemWidget(listOfOpenedFiles->item(j)))->setColorOfCheckBox(color);
-                break;
-          }
-      }
+      fileModel->setColor(data.get_name(i),QColor(color));
+      if(fanMode)
+        continue;
       k=0;
       for (int j = 0; j <listOfGraphs->count(); ++j) {
           if(((ExtendedListItem*)listOfGraphs->itemWidget(listOfGraphs->item(j)))->isChecked())
             {
-              webView(k)->page()->mainFrame()->evaluateJavaScript("name='"+listOfGraphNames[j]+"';");
-
-              webView(k)->page()->mainFrame()->evaluateJavaScript("DATA.push({name: '"+data.get_name(i)+"',color:'"+color+"',data: ["+data.get(i,j)+"],type: 'spline',tooltip: {valueDecimals: 5}});");
+              webView(k)->page()->mainFrame()->evaluateJavaScript("name="+jsString(listOfGraphNames[j])+";");
+
+              if(!comparison.isActive())
+                webView(k)->page()->mainFrame()->evaluateJavaScript("DATA.push({name: "+jsString(data.get_name(i))+",color:'"+color+"',data: ["+data.get(i,j)+"],type: 'spline',tooltip: {valueDecimals: 5}});");
+              else if(data.get_name(i)!=comparison.reference())
+              {
+                //ещё не посчитанная разность появится по comparison.changed()
+                const ComparisonEngine::Result *result=comparison.result(data.get_name(i),j);
+                const QVector<double> &time=data.time(data.findByName(comparison.reference()));
+                bool difference=comboComparisonMode->currentIndex()==ComparisonEngine::Difference;
+                QString name=difference ? data.get_name(i)+" - "+comparison.reference() : "|"+data.get_name(i)+" - "+comparison.reference()+"|";
+                if(result)
+                  webView(k)->page()->mainFrame()->evaluateJavaScript("DATA.push({name: "+jsString(name)+",color:'"+color+"',data: ["+GraphData::format(time.constData(),(difference ? result->difference : result->absError).constData(),time.size())+"],type: 'spline',tooltip: {valueDecimals: 5}});");
+              }
+              QString markers=eventMarkers(data.get_name(i));
+              if(!markers.isEmpty())
+                webView(k)->page()->mainFrame()->evaluateJavaScript("DATA.push({type: 'flags',name: "+jsString(data.get_name(i)+" events")+",color:'"+color+"',shape: 'squarepin',data: ["+markers+"]});");
 
               k++;
 
           }
       }
   }
+  if(fanMode)
+  {
+    //заливки перекрывают друг друга: каждая следующая закрашивает всё ниже своей границы
+    static const char *fills[PercentileFan::LevelCount]={"#fcfcfc","#c6dbef","#08519c","#6baed6","#c6dbef"};
+    QList<int> channels=checkedChannels();
+    for(k=0;k<channels.size();k++)
+    {
+      const PercentileFan::Band &band=fan.band(channels[k]);
+      for(int l=PercentileFan::LevelCount-1;l>=0;l--)
+      {
+        if(l==PercentileFan::P50)
+          continue;
+        QString points=GraphData::format(band.time.constData(),band.levels[l].constData(),band.time.size());
+        QString name=QString::number(PercentileFan::percent(l))+"%";
+        webView(k)->page()->mainFrame()->evaluateJavaScript("DATA.push({name: "+jsString(name)+",type: 'area',threshold: null,fillColor: '"+fills[l]+"',lineColor: '#6baed6',lineWidth: 1,dataGrouping: {enabled: false},data: ["+points+"]});");
+      }
+      QString median=GraphData::format(band.time.constData(),band.levels[PercentileFan::P50].constData(),band.time.size());
+      webView(k)->page()->mainFrame()->evaluateJavaScript("DATA.push({name: '50%',type: 'spline',color: '"+QString(fills[PercentileFan::P50])+"',dataGrouping: {enabled: false},data: ["+median+"]});");
+      if(data.findByName(fanSelected)!=-1)
+        webView(k)->page()->mainFrame()->evaluateJavaScript("DATA.push({id: 'selected',name: "+jsString(fanSelected)+",type: 'spline',color: '#c00',data: ["+data.get(data.findByName(fanSelected),channels[k])+"]});");
+    }
+  }
   k=0;
   for (int i = 0; i <listOfGraphs->count(); ++i) {
       if(((ExtendedListItem*)listOfGraphs->itemWidget(listOfGraphs->item(i)))->isChecked())
@@ -1191,6 +1587,479 @@ void Html5ApplicationViewer::show1()
   k++;
       }
   }
+  visibleBegin=-qInf();
+  visibleEnd=qInf();
+  updateStatistics();
+  trajectoryView->dataChanged();
+}
+
+QList<int> Html5ApplicationViewer::checkedChannels()
+{
+  QList<int> channels;
+  for (int i = 0; i <listOfGraphs->count(); ++i)
+    if(((ExtendedListItem*)listOfGraphs->itemWidget(listOfGraphs->item(i)))->isChecked())
+      channels<<i;
+  return channels;
+}
+
+void Html5ApplicationViewer::visibleRangeChanged(double min, double max)
+{
+  visibleBegin=min;
+  visibleEnd=max;
+  frames.request(RangeUpdate);
+}
+
+void Html5ApplicationViewer::loadVisibleWindow()
+{
+  //в режиме сравнения ряды пересчитаны на опорную шкалу, там остаётся обзор
+  if(comparison.isActive() || fanActive() || !qIsFinite(visibleBegin) || !qIsFinite(visibleEnd))
+    return;
+  QList<int> channels=checkedChannels();
+  double margin=(visibleEnd-visibleBegin)/2;
+  for(int i=0;i<data.length();i++)
+    if(data.needsLoad(i,channels,visibleBegin,visibleEnd))
+      loader.loadWindow(data.get_name(i),channels,visibleBegin-margin,visibleEnd+margin,KWindowPoints);
+}
+
+void Html5ApplicationViewer::updateStatistics()
+{
+  statisticsPanel->refresh(data,comparison,checkedChannels(),listOfGraphNames,visibleBegin,visibleEnd);
+}
+
+void Html5ApplicationViewer::updateReferenceList()
+{
+  QString current=comparison.reference();
+  comboReference->clear();
+  comboReference->addItem("No comparison");
+  for(int i=0;i<data.length();i++)
+    comboReference->addItem(data.get_name(i));
+  int index=comboReference->findText(current);
+  comboReference->setCurrentIndex(index>0 ? index : 0);
+  if(index<=0)
+    comparison.setReference("");
+}
+
+void Html5ApplicationViewer::addDerivedChannel()
+{
+  QString text=QInputDialog::getText(this,tr("Add channel"),tr("Expression (e.g. wheel_power_r - wheel_power_l, abs(line_position - 64), ma(current_wheel_angle, 20)):"));
+  if(text.trimmed().isEmpty())
+    return;
+  QString error;
+  if(!addExpression(text,error))
+    QMessageBox::warning(this,tr("Add channel"),error);
+}
+
+bool Html5ApplicationViewer::addExpression(const QString &text, QString &error)
+{
+  ChannelExpression expression;
+  if(!expression.compile(text))
+  {
+    error=expression.errorString();
+    return false;
+  }
+  data.addDerived(expression);
+  listOfGraphNames<<text;
+  ExtendedListItem *item=new ExtendedListItem(listOfGraphs,text,false);
+  connect(item,SIGNAL(checkBoxChanged(int)),SLOT(potomNazovuFunc()));
+  return true;
+}
+
+void Html5ApplicationViewer::saveSession()
+{
+  QString fileName=QFileDialog::getSaveFileName(this,tr("Save session"),lastPatch,"Sessions (*.gvs)");
+  if(fileName.isEmpty())
+    return;
+  QList<SessionSnapshot::Run> runs;
+  QList<int> rows=fileModel->checkedRows();
+  for(int i=0;i<rows.size();i++)
+  {
+    const FileListModel::Entry &item=fileModel->entry(rows[i]);
+    SessionSnapshot::Run run;
+    run.name=item.label;
+    run.path=item.path;
+    run.color=item.color;
+    run.size=item.size;
+    run.modified=item.modified;
+    run.kind=SessionSnapshot::PathOnly;
+    run.stale=false;
+    runs<<run;
+  }
+  SessionSnapshot::Layout layout;
+  layout.channels=checkedChannels();
+  layout.derived=listOfGraphNames.mid(GraphData::ChannelCount);
+  layout.reference=comparison.reference();
+  layout.comparisonMode=comboComparisonMode->currentIndex();
+  layout.overlayMode=comboOverlay->currentIndex();
+  if(!SessionSnapshot::save(fileName,data,runs,layout))
+    QMessageBox::warning(this,tr("Save session"),tr("Cannot write %1.").arg(fileName));
+}
+
+void Html5ApplicationViewer::openSession()
+{
+  QString fileName=QFileDialog::getOpenFileName(this,tr("Open session"),lastPatch,"Sessions (*.gvs)");
+  if(fileName.isEmpty())
+    return;
+  SessionSnapshot snapshot;
+  if(!snapshot.open(fileName))
+  {
+    QMessageBox::warning(this,tr("Open session"),tr("%1 is not a session file or is damaged.").arg(fileName));
+    return;
+  }
+  const SessionSnapshot::Layout &layout=snapshot.layout();
+  //текущие прогоны выгружаются снятием флажков, как вручную
+  QList<int> checked=fileModel->checkedRows();
+  for(int i=0;i<checked.size();i++)
+    fileModel->setData(fileModel->index(checked[i]),Qt::Unchecked,Qt::CheckStateRole);
+  QString error;
+  for(int i=0;i<layout.derived.size();i++)
+    if(!listOfGraphNames.contains(layout.derived[i]))
+      addExpression(layout.derived[i],error);
+  //номера производных каналов могли сместиться, они сопоставляются по выражению
+  QStringList channelNames;
+  for(int i=0;i<layout.channels.size();i++)
+  {
+    int channel=layout.channels[i];
+    if(channel<GraphData::ChannelCount)
+      channelNames<<listOfGraphNames.value(channel);
+    else
+      channelNames<<layout.derived.value(channel-GraphData::ChannelCount);
+  }
+  for(int i=0;i<listOfGraphs->count();i++)
+  {
+    ExtendedListItem *item=(ExtendedListItem*)listOfGraphs->itemWidget(listOfGraphs->item(i));
+    if(item->isChecked()!=channelNames.contains(listOfGraphNames[i]))
+      item->Check();
+  }
+  //столбцы берутся из снимка целиком; лог, изменившийся после сохранения, читается заново
+  const QList<SessionSnapshot::Run> &runs=snapshot.runs();
+  QVector<FileListModel::Entry> entries;
+  QList<int> reread;
+  for(int i=0;i<runs.size();i++)
+  {
+    int row=fileModel->find(runs[i].path);
+    if(row!=-1)
+      fileModel->removeFile(row);
+    //имя прогона из снимка должно остаться прежним, одноимённая строка другого файла уступает его
+    row=fileModel->findLabel(runs[i].name);
+    if(row!=-1)
+      fileModel->removeFile(row);
+    FileListModel::Entry entry=FileListModel::makeEntry(runs[i].path,runs[i].name);
+    entry.checked=true;
+    entry.color=runs[i].color;
+    entries<<entry;
+    if(snapshot.restore(i,data))
+      events.scan(runs[i].name);
+    else
+      reread<<i;
+  }
+  snapshot.close();
+  //addFiles не сообщает об отмеченных строках, чтение запускается здесь
+  fileModel->addFiles(entries);
+  for(int i=0;i<reread.size();i++)
+    loader.start(runs[reread[i]].name,runs[reread[i]].path,entries[reread[i]].size>KRangeLoadThreshold);
+  updateReferenceList();
+  int reference=comboReference->findText(layout.reference);
+  comboReference->setCurrentIndex(reference>0 ? reference : 0);
+  comparison.setReference(reference>0 ? layout.reference : QString());
+  comboComparisonMode->setCurrentIndex(qBound(0,layout.comparisonMode,comboComparisonMode->count()-1));
+  comboOverlay->setCurrentIndex(qBound(0,layout.overlayMode,comboOverlay->count()-1));
+  show1();
+}
+
+void Html5ApplicationViewer::showSpectrum()
+{
+  spectrumView->refreshLists(listOfGraphNames);
+  spectrumView->show();
+  spectrumView->raise();
+}
+
+void Html5ApplicationViewer::showTrajectory()
+{
+  trajectoryView->refreshLists(listOfGraphNames);
+  trajectoryView->show();
+  trajectoryView->raise();
+}
+
+void Html5ApplicationViewer::showDensity()
+{
+  densityView->refreshLists(listOfGraphNames);
+  densityView->show();
+  densityView->raise();
+}
+
+void Html5ApplicationViewer::showReplay()
+{
+  //кадры камеры не хранятся в GraphData, проигрыватель читает их из файла прогона
+  QStringList runs;
+  QStringList fileNames;
+  QList<int> rows=fileModel->checkedRows();
+  for(int i=0;i<rows.size();i++)
+  {
+    const FileListModel::Entry &item=fileModel->entry(rows[i]);
+    if(data.findByName(item.label)==-1)
+      continue;
+    runs<<item.label;
+    fileNames<<item.path;
+  }
+  replayView->refreshLists(runs,fileNames);
+  replayView->setStartTime(cursorTime);
+  replayView->show();
+  replayView->raise();
+}
+
+void Html5ApplicationViewer::replayTimeChanged(double t)
+{
+  setChartCursor(t);
+  trajectoryView->setMarkerTime(t);
+}
+
+void Html5ApplicationViewer::setChartCursor(double t)
+{
+  cursorTime=t;
+  frames.request(CursorUpdate);
+}
+
+void Html5ApplicationViewer::chartHovered(double t)
+{
+  hoverTime=t;
+  frames.request(HoverUpdate);
+}
+
+void Html5ApplicationViewer::renderFrame(int updates)
+{
+  //за кадр применяется только последнее состояние каждого вида
+  if(updates&RangeUpdate)
+  {
+    loadVisibleWindow();
+    updateStatistics();
+  }
+  if(updates&HoverUpdate)
+  {
+    trajectoryView->setMarkerTime(hoverTime);
+    QList<int> channels=checkedChannels();
+    for(int k=0;k<channels.size();k++)
+      webView(k)->page()->mainFrame()->evaluateJavaScript("setCrosshair("+QString::number(hoverTime,'f')+","+jsString(crosshairText(channels[k],hoverTime))+");");
+  }
+  if(updates&CursorUpdate)
+  {
+    int count=checkedChannels().length();
+    for(int i=0;i<count;i++)
+      webView(i)->page()->mainFrame()->evaluateJavaScript("setCursor("+QString::number(cursorTime,'f')+");");
+  }
+}
+
+QString Html5ApplicationViewer::crosshairText(int channel, double t)
+{
+  char buffer[FloatFormat::KMaxFixedLength];
+  QString result="<b>"+QString::fromLatin1(buffer,FloatFormat::fixed(t,3,buffer))+" s</b>";
+  QList<int> runs;
+  if(fanActive())
+  {
+    //в сводке - процентили в ближайшем узле сетки и только показанные поверх неё прогоны
+    const PercentileFan::Band &band=fan.band(channel);
+    int node=std::lower_bound(band.time.constBegin(),band.time.constEnd(),t)-band.time.constBegin();
+    if(node>0 && (node==band.time.size() || t-band.time[node-1]<band.time[node]-t))
+      node--;
+    for(int l=PercentileFan::LevelCount-1;l>=0 && node<band.time.size();l--)
+    {
+      result+="<br/>"+QString::number(PercentileFan::percent(l))+"%: ";
+      if(FloatFormat::isFinite(band.levels[l][node]))
+        result+=QString::fromLatin1(buffer,FloatFormat::shortest(band.levels[l][node],buffer));
+      else
+        result+="null";
+    }
+    if(data.findByName(fanSelected)!=-1)
+      runs<<data.findByName(fanSelected);
+    if(data.findByName(fanHovered)!=-1 && fanHovered!=fanSelected)
+      runs<<data.findByName(fanHovered);
+  }
+  else
+    for(int i=0;i<data.length();i++)
+      runs<<i;
+  for(int r=0;r<runs.size();r++)
+  {
+    const int i=runs[r];
+    int sample=data.nearestSample(i,t);
+    result+="<br/>"+data.get_name(i).toHtmlEscaped()+": ";
+    const QVector<float> &values=data.column(i,channel);
+    if(sample==-1 || sample>=values.size() || !FloatFormat::isFinite(values[sample]))
+      result+="null";
+    else
+      result+=QString::fromLatin1(buffer,FloatFormat::shortest(values[sample],buffer));
+  }
+  return result;
+}
+
+bool Html5ApplicationViewer::fanActive()
+{
+  return comboOverlay->currentIndex()==1 && !comparison.isActive();
+}
+
+void Html5ApplicationViewer::setRunOverlay(const QString &id, const QString &run)
+{
+  int index=data.findByName(run);
+  QString color=id=="selected" ? "#c00" : "#f80";
+  QList<int> channels=checkedChannels();
+  for(int k=0;k<channels.size();k++)
+    webView(k)->page()->mainFrame()->evaluateJavaScript("setRunOverlay("+jsString(id)+","+jsString(run)+","+jsString(color)+",["+(index==-1 ? QString() : data.get(index,channels[k]))+"]);");
+}
+
+void Html5ApplicationViewer::fileClicked(const QModelIndex &index)
+{
+  if(!fanActive())
+    return;
+  //повторный щелчок снимает выбор
+  QString run=fileModel->entry(fileProxy->mapToSource(index).row()).label;
+  fanSelected=run==fanSelected ? QString() : run;
+  setRunOverlay("selected",fanSelected);
+}
+
+void Html5ApplicationViewer::fileHovered(const QModelIndex &index)
+{
+  if(!fanActive())
+    return;
+  QString run=fileModel->entry(fileProxy->mapToSource(index).row()).label;
+  if(run==fanHovered)
+    return;
+  fanHovered=run;
+  setRunOverlay("hovered",run==fanSelected ? QString() : run);
+}
+
+void Html5ApplicationViewer::fileUnhovered()
+{
+  if(fanHovered.isEmpty())
+    return;
+  fanHovered.clear();
+  if(fanActive())
+    setRunOverlay("hovered",QString());
+}
+
+QString Html5ApplicationViewer::eventMarkers(const QString &run)
+{
+  static const char *titles[]={"L","N","J","S","T"};
+  QVector<EventDetector::Event> list=events.events(run);
+  QString result;
+  for(int i=0;i<list.size() && i<KMaxListedEvents;i++)
+  {
+    if(i)
+      result+=",";
+    QString text=EventDetector::typeName(list[i].type);
+    if(list[i].type==EventDetector::Threshold)
+      text+=": "+listOfGraphNames.value(list[i].channel);
+    result+="{x:"+QString::number(list[i].tBegin,'f')+",title:'"+titles[list[i].type]+"',text:"+jsString(text)+"}";
+  }
+  return result;
+}
+
+void Html5ApplicationViewer::eventsChanged()
+{
+  listOfEvents->clear();
+  for(int i=0;i<data.length();i++)
+  {
+    QVector<EventDetector::Event> list=events.events(data.get_name(i));
+    for(int j=0;j<list.size() && j<KMaxListedEvents;j++)
+    {
+      QString text=data.get_name(i)+": "+EventDetector::typeName(list[j].type);
+      if(list[j].type==EventDetector::Threshold)
+        text+=" ("+listOfGraphNames.value(list[j].channel)+")";
+      text+=QString(" %1 - %2 s").arg(list[j].tBegin,0,'f',3).arg(list[j].tEnd,0,'f',3);
+      QListWidgetItem *item=new QListWidgetItem(text,listOfEvents);
+      item->setData(Qt::UserRole,list[j].tBegin);
+      item->setData(Qt::UserRole+1,list[j].tEnd);
+    }
+  }
+  //в сводке процентилей метки отдельных прогонов не показываются
+  if(fanActive())
+    return;
+  if(comparison.isActive())
+  {
+    show1();
+    return;
+  }
+  //метки обновляются на месте, без перестроения графиков и сброса масштаба
+  int count=checkedChannels().length();
+  for(int i=0;i<data.length();i++)
+  {
+    QString markers=eventMarkers(data.get_name(i));
+    for(int k=0;k<count;k++)
+      webView(k)->page()->mainFrame()->evaluateJavaScript("setEventFlags("+jsString(data.get_name(i))+",["+markers+"]);");
+  }
+}
+
+void Html5ApplicationViewer::jumpToEvent(QListWidgetItem *item)
+{
+  double tBegin=item->data(Qt::UserRole).toDouble();
+  double tEnd=item->data(Qt::UserRole+1).toDouble();
+  double margin=qMax(1.0,tEnd-tBegin);
+  int count=checkedChannels().length();
+  for(int i=0;i<count;i++)
+    webView(i)->page()->mainFrame()->evaluateJavaScript("setWindow("+QString::number(tBegin-margin,'f')+","+QString::number(tEnd+margin,'f')+");");
+  setChartCursor(tBegin);
+  trajectoryView->setMarkerTime(tBegin);
+}
+
+void Html5ApplicationViewer::addThreshold()
+{
+  bool ok;
+  QString channel=QInputDialog::getItem(this,tr("Add threshold"),tr("Channel:"),listOfGraphNames,0,false,&ok);
+  if(!ok)
+    return;
+  QString text=QInputDialog::getText(this,tr("Add threshold"),tr("Condition (e.g. > 0.5 or < -0.5):"),QLineEdit::Normal,"> 0",&ok).trimmed();
+  if(!ok)
+    return;
+  EventDetector::Condition condition;
+  condition.channel=listOfGraphNames.indexOf(channel);
+  condition.above=text.startsWith('>');
+  condition.level=text.mid(1).trimmed().toFloat(&ok);
+  if(!ok || !(text.startsWith('>') || text.startsWith('<')))
+  {
+    QMessageBox::warning(this,tr("Add threshold"),tr("Expected '> value' or '< value'"));
+    return;
+  }
+  if(!events.addCondition(condition))
+    QMessageBox::warning(this,tr("Add threshold"),tr("Too many thresholds"));
+}
+
+void Html5ApplicationViewer::exportData()
+{
+  if(exporter.isRunning())
+  {
+    exporter.cancel();
+    return;
+  }
+  QString filter;
+  QString fileName=QFileDialog::getSaveFileName(this,"Export data",lastPatch,"CSV (*.csv);;Columnar (*.gvc)",&filter);
+  if(fileName.isEmpty())
+    return;
+  //выгружаются все загруженные прогоны и отмеченные каналы (или все) в видимом диапазоне
+  QList<int> runs;
+  for(int i=0;i<data.length();i++)
+    runs<<i;
+  QList<int> channels=checkedChannels();
+  if(channels.isEmpty())
+    for(int i=0;i<data.channelCount();i++)
+      channels<<i;
+  LogExporter::Format format=filter.startsWith("Columnar") ? LogExporter::Columnar : LogExporter::Csv;
+  if(exporter.start(fileName,format,runs,channels,listOfGraphNames,visibleBegin,visibleEnd))
+    exportProgress(0);
+}
+
+void Html5ApplicationViewer::exportProgress(int percent)
+{
+  button_Export->setText(QString("Cancel export (%1%)").arg(percent));
+}
+
+void Html5ApplicationViewer::exportFinished(bool ok)
+{
+  button_Export->setText("Export data");
+  if(!ok && !exporter.errorString().isEmpty())
+    QMessageBox::warning(this,tr("Export data"),exporter.errorString());
+}
+
+void Html5ApplicationViewer::comparisonChanged()
+{
+  comparison.setReference(comboReference->currentIndex()>0 ? comboReference->currentText() : QString());
+  show1();
 }
 
 void Html5ApplicationViewer::potomNazovuFunc()
@@ -1200,6 +2069,8 @@ void Html5ApplicationViewer::potomNazovuFunc()
     if(((ExtendedListItem*)listOfGraphs->itemWidget(listOfGraphs->item(i)))->isChecked())
       count++;
     redivisionGraph(count);
+    //у частично загруженных прогонов в окне только столбцы прежних каналов
+    loadVisibleWindow();
   }
 void Html5ApplicationViewer::saveImages()
 {
@@ -1244,15 +2115,13 @@ void Html5ApplicationViewer::saveImages()
                 str=str.mid(-1,str.indexOf("height=\"")+9)+"100%"+(str.mid(str.indexOf("height=\"")+9,str.length())).mid((str.mid(str.indexOf("height=\"")+9,str.length())).indexOf("\""),str.length());
                 str=str.mid(-1,str.indexOf("width=\"")+9)+"100%"+(str.mid(str.indexOf("width=\"")+9,str.length())).mid((str.mid(str.indexOf("width=\"")+9,str.length())).indexOf("\""),str.length());
                 height=QString::number(height.toInt()-40);
-                for (int j = 0; j < listOfOpenedFiles->count(); ++j) {
-                    ExtendedListItem *item=(ExtendedListItem*)listOfOpenedFiles->itemWidget(listOfOpenedFiles->item(j));
-                    if(item->isChecked())
-                    {
-                        str=str.mid(-1,str.length()-5)+"<rect rx=\"3\" ry=\"3\" fill=\""+item->getColor()+"\" x=\"5\" y=\""+QString::number(height.toInt()-6)+"\" width=\"20\" height=\"3\"></rect><text x=\"30\" y=\""+height+"\" style=\"font-family:&quot;Lucida Grande&quot;, &quot;Lucida Sans Unicode&quot;, Verdana, Arial, Helvetica, sans-serif;font-size:12px;color:#333333;fill:#333333;\" zIndex=\"1\">"+item->getLabelText()+"</text></svg>";
-                        height=QString::number((height.toInt())+20);
-                    }
+                QList<int> checkedFiles=fileModel->checkedRows();
+                for (int j = 0; j < checkedFiles.length(); ++j) {
+                    const FileListModel::Entry &item=fileModel->entry(checkedFiles[j]);
+                    str=str.mid(-1,str.length()-5)+"<rect rx=\"3\" ry=\"3\" fill=\""+item.color.name()+"\" x=\"5\" y=\""+QString::number(height.toInt()-6)+"\" width=\"20\" height=\"3\"></rect><text x=\"30\" y=\""+height+"\" style=\"font-family:&quot;Lucida Grande&quot;, &quot;Lucida Sans Unicode&quot;, Verdana, Arial, Helvetica, sans-serif;font-size:12px;color:#333333;fill:#333333;\" zIndex=\"1\">"+item.label+"</text></svg>";
+                    height=QString::number((height.toInt())+20);
                 }
-                QFile file(lastPatch+" "+listOfGraphNames[i]+".svg");
+                QFile file(lastPatch+" "+QString(listOfGraphNames[i]).replace("/","_")+".svg");
                 if(file.open(QIODevice::WriteOnly|QIODevice::Text))
                 {
                     QTextStream stream(&file);
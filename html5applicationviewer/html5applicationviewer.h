@@ -8,9 +8,27 @@
 #include <QSplitter>
 #include <QListWidget>
 #include <QFileDialog>
+#include <QComboBox>
+#include <QLabel>
+#include <QListView>
+#include <QSortFilterProxyModel>
 
 #include "logger.h"
 #include "graphdata.h"
+#include "statisticspanel.h"
+#include "comparisonengine.h"
+#include "percentilefan.h"
+#include "spectrumview.h"
+#include "trajectoryview.h"
+#include "densityview.h"
+#include "replayview.h"
+#include "eventdetector.h"
+#include "filelist.h"
+#include "logcatalog.h"
+#include "progressiveloader.h"
+#include "liveingest.h"
+#include "logexporter.h"
+#include "framescheduler.h"
 
 class QGraphicsWebView;
 
@@ -18,13 +36,50 @@ class Html5ApplicationViewer : public QWidget
 {
     Q_OBJECT
     GraphData data;//обьект для хранения данных графиков
-    QListWidget *listOfOpenedFiles;//список открытых файлов
+    QListView *listOfOpenedFiles;//список открытых файлов
+    FileListModel *fileModel;
+    QSortFilterProxyModel *fileProxy;//фильтр и сортировка списка файлов
+    LogCatalog catalog;//все когда-либо открытые каталоги с логами
     QListWidget *listOfGraphs;//список типов графиков для отображения
     QString lastPatch="";//путь последнегоудачного открытия файла
     QFrame *frameWithGraphs;//фрейм в котором будут отображатся графики
     QStringList listOfGraphNames;
     QPushButton *button_Save;
+    QPushButton *button_Export;//во время выгрузки - её отмена
+    StatisticsPanel *statisticsPanel;//статистика по видимому диапазону
+    double visibleBegin;//видимый диапазон времени
+    double visibleEnd;
+    ComparisonEngine comparison;//сравнение прогонов с опорным
+    QComboBox *comboReference;//выбор опорного прогона
+    QComboBox *comboComparisonMode;//разность или модуль ошибки
+    PercentileFan fan;//сводка процентилей вместо отдельных прогонов
+    QComboBox *comboOverlay;//все прогоны или сводка процентилей
+    QString fanSelected;//прогоны, показываемые поверх сводки: выбранный в списке файлов
+    QString fanHovered;//и находящийся под курсором
+    SpectrumView *spectrumView;//окно спектра
+    TrajectoryView *trajectoryView;//траектория, вид сверху
+    DensityView *densityView;//плотность пар значений двух каналов
+    ReplayView *replayView;//воспроизведение прогона с кадрами камеры
+    EventDetector events;//события по прогонам
+    ProgressiveLoader loader;//фоновая загрузка логов
+    LiveIngest live;//записи от симулятора через локальный сокет
+    LogExporter exporter;//выгрузка в фоне
+    QLabel *liveStatus;//скорость приёма и задержка до графика
+    enum FrameUpdate{RangeUpdate=1,HoverUpdate=2,CursorUpdate=4};
+    FrameScheduler frames;//перерисовка по видимому диапазону и наведению не чаще раза за кадр
+    double hoverTime;//время под курсором на графике
+    double cursorTime;//время, отмечаемое линией на графиках
+    QListWidget *listOfEvents;//список событий для перехода
     void addFileToList(QString fileName);//добавление файлов в
+    QList<int> checkedChannels();//номера отмеченных типов графиков
+    QString eventMarkers(const QString &run);//точки flags-серии для графика
+    QString crosshairText(int channel,double t);//значения всех прогонов в ближайших к t отсчётах
+    bool fanActive();//при сравнении прогонов сводка не строится
+    void setRunOverlay(const QString &id,const QString &run);//прогон поверх сводки, пустое имя - убрать
+    void addCatalogEntries(const QVector<LogCatalog::Entry> &found,const QString &root);
+    void loadVisibleWindow();//подробное окно для прогонов, загруженных частично
+    bool addExpression(const QString &text,QString &error);//канал-выражение в список графиков
+    void reportDamage(const QString &label,const Logger::DamageReport &damage);//что пропущено при чтении повреждённого лога
 public:
     enum ScreenOrientation {
         ScreenOrientationLockPortrait
@@ -39,14 +94,49 @@ public:
 private:
     class Html5ApplicationViewerPrivate **view;//область для отображения html-страницы
 public slots:
-    void deleteItem();//удаление из списка
+    void deleteItem(const QModelIndex &index);//удаление из списка
+    void sortFiles(int column);
+    void folderIndexed(const QString &root);
+    void findRuns();//поиск по каталогу
     void openFolder();//открытие папки
     void openFile();//открытие файла
     void selectItem(QListWidgetItem* listWidgetItem);//установка галочек выбора
-    void selectItemToShow(int i);//Загрузка/удаление данных из файла в программе
+    void selectItemToShow(int row,bool checked);//Загрузка/удаление данных из файла в программе
     void show1();//перерисовка графика
     void potomNazovuFunc();//функция для обработки выбора типа графика
     void saveImages();
+    void visibleRangeChanged(double min,double max);//смена видимого диапазона на графике
+    void updateStatistics();
+    void updateReferenceList();//обновление списка прогонов для сравнения
+    void comparisonChanged();
+    void fileClicked(const QModelIndex &index);//выбор прогона для показа поверх сводки
+    void fileHovered(const QModelIndex &index);
+    void fileUnhovered();
+    void addDerivedChannel();//добавление канала-выражения
+    void saveSession();//снимок открытых прогонов и вида графиков
+    void openSession();
+    void showSpectrum();
+    void showTrajectory();
+    void showDensity();
+    void showReplay();
+    void replayTimeChanged(double t);//курсор и маркер траектории идут за воспроизведением
+    void setChartCursor(double t);//вертикальная линия на всех графиках
+    void chartHovered(double t);
+    void renderFrame(int updates);
+    void eventsChanged();
+    void jumpToEvent(QListWidgetItem *item);
+    void addThreshold();//порог по каналу для поиска событий
+    void exportData();//выгрузка в CSV или столбцовый формат
+    void exportProgress(int percent);
+    void exportFinished(bool ok);
+    void runLoaded(const QString &run,const Logger::DamageReport &damage);//файл прочитан целиком
+    void runRefined(const QString &run,bool final);//очередной проход постепенной загрузки
+    void windowLoaded(const QString &run);//подробное окно видимого диапазона
+    void runDamaged(const QString &run,const QString &fileName);
+    void toggleLive(bool on);//приём записей от симулятора; выключение убирает живые прогоны
+    void liveStarted(const QString &run);
+    void liveAppended(const QString &run,int first);//дописаны отсчёты начиная с first
+    void liveFinished(const QString &run);
 };
 
 #endif
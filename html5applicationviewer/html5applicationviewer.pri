@@ -8,13 +8,70 @@ QT += webkit
 
 SOURCES += $$PWD/html5applicationviewer.cpp \
     html5applicationviewer/logger.cc \
+    html5applicationviewer/logformat.cpp \
     html5applicationviewer/extendedlistitem.cpp \
-    html5applicationviewer/graphdata.cpp
+    html5applicationviewer/graphdata.cpp \
+    html5applicationviewer/channelstatistics.cpp \
+    html5applicationviewer/statisticspanel.cpp \
+    html5applicationviewer/comparisonengine.cpp \
+    html5applicationviewer/channelexpression.cpp \
+    html5applicationviewer/fft.cpp \
+    html5applicationviewer/resample.cpp \
+    html5applicationviewer/spectrumanalysis.cpp \
+    html5applicationviewer/spectrumview.cpp \
+    html5applicationviewer/spatialindex.cpp \
+    html5applicationviewer/trajectoryview.cpp \
+    html5applicationviewer/eventdetector.cpp \
+    html5applicationviewer/lograngereader.cpp \
+    html5applicationviewer/logexporter.cpp \
+    html5applicationviewer/floatformat.cpp \
+    html5applicationviewer/filelist.cpp \
+    html5applicationviewer/logcatalog.cpp \
+    html5applicationviewer/progressiveloader.cpp \
+    html5applicationviewer/framescheduler.cpp \
+    html5applicationviewer/percentilefan.cpp \
+    html5applicationviewer/densityhistogram.cpp \
+    html5applicationviewer/densityview.cpp \
+    html5applicationviewer/replayplayer.cpp \
+    html5applicationviewer/replayview.cpp \
+    html5applicationviewer/sessionsnapshot.cpp \
+    html5applicationviewer/liveingest.cpp \
+    html5applicationviewer/sharedring.cpp
 HEADERS += $$PWD/html5applicationviewer.h \
     html5applicationviewer/logger.h \
+    html5applicationviewer/logformat.h \
+    html5applicationviewer/spscringbuffer.h \
     html5applicationviewer/common.h \
     html5applicationviewer/extendedlistitem.h \
-    html5applicationviewer/graphdata.h
+    html5applicationviewer/graphdata.h \
+    html5applicationviewer/channelstatistics.h \
+    html5applicationviewer/statisticspanel.h \
+    html5applicationviewer/comparisonengine.h \
+    html5applicationviewer/channelexpression.h \
+    html5applicationviewer/fft.h \
+    html5applicationviewer/resample.h \
+    html5applicationviewer/spectrumanalysis.h \
+    html5applicationviewer/spectrumview.h \
+    html5applicationviewer/spatialindex.h \
+    html5applicationviewer/trajectoryview.h \
+    html5applicationviewer/eventdetector.h \
+    html5applicationviewer/lograngereader.h \
+    html5applicationviewer/logexporter.h \
+    html5applicationviewer/floatformat.h \
+    html5applicationviewer/filelist.h \
+    html5applicationviewer/logcatalog.h \
+    html5applicationviewer/progressiveloader.h \
+    html5applicationviewer/taskscheduler.h \
+    html5applicationviewer/framescheduler.h \
+    html5applicationviewer/percentilefan.h \
+    html5applicationviewer/densityhistogram.h \
+    html5applicationviewer/densityview.h \
+    html5applicationviewer/replayplayer.h \
+    html5applicationviewer/replayview.h \
+    html5applicationviewer/sessionsnapshot.h \
+    html5applicationviewer/livestream.h \
+    html5applicationviewer/liveingest.h \
+    html5applicationviewer/sharedring.h
 INCLUDEPATH += $$PWD
 # This file was generated by an application wizard of Qt Creator.
 # The code below handles deployment to Android and Maemo, aswell as copying
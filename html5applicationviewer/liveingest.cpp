@@ -0,0 +1,299 @@
+#include "liveingest.h"
+
+static const int KReadBufferSize = 1024*1024;//байт, сверх этого сокет не читает из ядра
+static const double KSmoothing = 0.1;//вес новой пачки в сглаженных скорости и задержке
+
+LiveIngest::LiveIngest(GraphData &data, QObject *parent)
+    : QObject(parent)
+    , m_data(data)
+{
+    connect(&m_server,SIGNAL(newConnection()),SLOT(acceptConnections()));
+    m_flushTimer.setInterval(KFlushIntervalMs);
+    connect(&m_flushTimer,SIGNAL(timeout()),SLOT(flush()));
+}
+
+LiveIngest::~LiveIngest()
+{
+    stop();
+}
+
+bool LiveIngest::listen(const QString &serverName)
+{
+    stop();
+    m_stats.clear();
+    //сокет, оставшийся от аварийно завершённого процесса, иначе не даст начать
+    QLocalServer::removeServer(serverName);
+    if(!m_server.listen(serverName))
+        return false;
+    m_serverName=serverName;
+    m_flushTimer.start();
+    return true;
+}
+
+void LiveIngest::stop()
+{
+    while(!m_connections.isEmpty())
+        close(0);
+    if(m_ring.mode()!=SharedRing::Closed)
+    {
+        m_ring.close();
+        m_stats[m_ringRun].connected=false;
+        emit finished(m_ringRun);
+    }
+    m_server.close();
+    m_flushTimer.stop();
+}
+
+QStringList LiveIngest::runs() const
+{
+    return m_stats.keys();
+}
+
+LiveIngest::Stats LiveIngest::stats(const QString &run) const
+{
+    return m_stats.value(run);
+}
+
+void LiveIngest::acceptConnections()
+{
+    while(m_server.hasPendingConnections())
+    {
+        Connection connection;
+        connection.socket=m_server.nextPendingConnection();
+        connection.socket->setReadBufferSize(KReadBufferSize);
+        connection.stalled=false;
+        connect(connection.socket,SIGNAL(readyRead()),SLOT(readConnection()));
+        connect(connection.socket,SIGNAL(disconnected()),SLOT(connectionClosed()));
+        m_connections<<connection;
+        if(!read(m_connections.last()))
+            close(m_connections.size()-1);
+    }
+}
+
+int LiveIngest::find(QObject *socket) const
+{
+    for(int i=0;i<m_connections.size();i++)
+        if(m_connections[i].socket==socket)
+            return i;
+    return -1;
+}
+
+void LiveIngest::readConnection()
+{
+    int index=find(sender());
+    if(index!=-1 && !read(m_connections[index]))
+        close(index);
+}
+
+bool LiveIngest::read(Connection &connection)
+{
+    QLocalSocket *socket=connection.socket;
+    LiveStream::Header header;
+    char head[LiveStream::HeaderSize];
+    while(socket->bytesAvailable()>=LiveStream::HeaderSize)
+    {
+        if(connection.pending.size()>=KMaxPending)
+        {
+            //данные остаются в сокете до следующего flush
+            if(!connection.stalled)
+                m_stats[connection.run].stalls++;
+            connection.stalled=true;
+            return true;
+        }
+        socket->peek(head,LiveStream::HeaderSize);
+        if(!LiveStream::decodeHeader(head,header))
+            return false;
+        if(socket->bytesAvailable()<LiveStream::HeaderSize+qint64(header.length))
+        {
+            //кадр больше буфера чтения не поместился бы в него никогда
+            if(socket->readBufferSize()<LiveStream::HeaderSize+qint64(header.length))
+                socket->setReadBufferSize(LiveStream::HeaderSize+header.length);
+            return true;
+        }
+        socket->read(head,LiveStream::HeaderSize);
+        QByteArray payload=socket->read(header.length);
+        if(header.type==LiveStream::Hello)
+        {
+            if(!connection.run.isEmpty())
+                return false;
+            //переподключение с тем же именем начинает прогон заново
+            QString run="live/"+QString::fromUtf8(payload);
+            for(int i=0;i<m_connections.size();i++)
+                if(m_connections[i].run==run)
+                    return false;
+            if(m_ring.mode()!=SharedRing::Closed && m_ringRun==run)
+                return false;
+            connection.run=run;
+            if(m_data.findByName(connection.run)!=-1)
+                m_data.deleteByName(connection.run);
+            m_data.createNew(connection.run);
+            Stats stats;
+            stats.connected=true;
+            m_stats.insert(connection.run,stats);
+            connection.sinceFlush.start();
+            emit started(connection.run);
+            continue;
+        }
+        const int size=LogFormat::recordSize(header.version);
+        if(header.type!=LiveStream::Batch || connection.run.isEmpty() || size==0 || header.length%size!=0)
+            return false;
+        const int count=header.length/size;
+        const int first=connection.pending.size();
+        connection.pending.resize(first+count);
+        for(int i=0;i<count;i++)
+            LogFormat::decode(payload.constData()+i*size,header.version,connection.pending[first+i]);
+        connection.sendTimes<<header.sendTime;
+    }
+    return true;
+}
+
+int LiveIngest::append(Connection &connection)
+{
+    int index=m_data.findByName(connection.run);
+    //прогон убран из GraphData - данные больше некуда дописывать
+    int first=index==-1 ? -1 : m_data.time(index).size();
+    if(index!=-1)
+        m_data.addTo(index,connection.pending.constData(),connection.pending.size());
+    connection.pending.clear();
+    return first;
+}
+
+void LiveIngest::delivered(const QString &run, int first, int count, QElapsedTimer &sinceFlush, const QVector<qint64> &sendTimes)
+{
+    emit appended(run,first);
+    //графики обновлены синхронно в обработчике appended: задержка включает отрисовку
+    const qint64 now=LiveStream::now();
+    Stats &stats=m_stats[run];
+    const double elapsed=sinceFlush.restart()/1000.0;
+    const bool firstFlush=stats.records==0;
+    if(elapsed>0)
+        stats.rate=firstFlush ? count/elapsed : stats.rate+KSmoothing*(count/elapsed-stats.rate);
+    stats.records+=count;
+    for(int j=0;j<sendTimes.size();j++)
+    {
+        const double latency=(now-sendTimes[j])/1000.0;
+        stats.latencyMean=firstFlush && j==0 ? latency : stats.latencyMean+KSmoothing*(latency-stats.latencyMean);
+        stats.latency=latency;
+        stats.latencyMax=qMax(stats.latencyMax,latency);
+    }
+}
+
+void LiveIngest::flushRing()
+{
+    //кольцо ищется под тем же именем, что и сокет; писатель мог ещё не создать его
+    if(m_ring.mode()==SharedRing::Closed)
+    {
+        if(!m_ring.attach(m_serverName))
+            return;
+        m_ringRun="live/"+m_ring.run();
+        for(int i=0;i<m_connections.size();i++)
+            if(m_connections[i].run==m_ringRun)
+            {
+                m_ring.close();
+                return;
+            }
+        if(m_data.findByName(m_ringRun)!=-1)
+            m_data.deleteByName(m_ringRun);
+        m_data.createNew(m_ringRun);
+        Stats stats;
+        stats.connected=true;
+        m_stats.insert(m_ringRun,stats);
+        m_ringSinceFlush.start();
+        emit started(m_ringRun);
+    }
+    //флаг читается до слотов, чтобы не потерять записи, добавленные перед закрытием
+    const bool closed=m_ring.isFinished();
+    const int index=m_data.findByName(m_ringRun);
+    const int first=index==-1 ? -1 : m_data.time(index).size();
+    const DataSet *records;
+    qint64 sendTime=0;
+    QVector<qint64> sendTimes;
+    int count=0;
+    int chunk;
+    //записи дописываются прямо из сегмента, без промежуточной копии
+    while(count<KMaxPending && (chunk=m_ring.peek(records,sendTime))>0)
+    {
+        chunk=qMin(chunk,KMaxPending-count);
+        if(index!=-1)
+            m_data.addTo(index,records,chunk);
+        m_ring.release(chunk);
+        sendTimes<<sendTime;
+        count+=chunk;
+    }
+    Stats &stats=m_stats[m_ringRun];
+    if(count==KMaxPending)
+        stats.stalls++;
+    if(count>0 && index!=-1)
+        delivered(m_ringRun,first,count,m_ringSinceFlush,sendTimes);
+    stats.pending=int(m_ring.lag());
+    stats.dropped=m_ring.dropped();
+    if(closed && m_ring.lag()==0)
+    {
+        m_ring.close();
+        stats.connected=false;
+        emit finished(m_ringRun);
+    }
+}
+
+void LiveIngest::flush()
+{
+    flushRing();
+    for(int i=0;i<m_connections.size();i++)
+    {
+        Connection &connection=m_connections[i];
+        if(connection.pending.isEmpty())
+            continue;
+        const int count=connection.pending.size();
+        const int first=append(connection);
+        if(first==-1)
+        {
+            connection.sendTimes.clear();
+            continue;
+        }
+        delivered(connection.run,first,count,connection.sinceFlush,connection.sendTimes);
+        connection.sendTimes.clear();
+        //отставание разобрано, чтение продолжается
+        if(connection.stalled)
+        {
+            connection.stalled=false;
+            if(!read(connection))
+            {
+                close(i--);
+                continue;
+            }
+        }
+        m_stats[connection.run].pending=connection.pending.size();
+    }
+}
+
+void LiveIngest::connectionClosed()
+{
+    int index=find(sender());
+    if(index==-1)
+        return;
+    //то, что отправитель успел записать до отключения, ещё лежит в сокете
+    Connection &connection=m_connections[index];
+    while(read(connection) && connection.stalled)
+    {
+        m_stats[connection.run].records+=connection.pending.size();
+        append(connection);
+        connection.stalled=false;
+    }
+    close(index);
+}
+
+void LiveIngest::close(int index)
+{
+    Connection connection=m_connections.takeAt(index);
+    disconnect(connection.socket,0,this,0);
+    connection.socket->abort();
+    connection.socket->deleteLater();
+    if(connection.run.isEmpty())
+        return;
+    Stats &stats=m_stats[connection.run];
+    stats.records+=connection.pending.size();
+    append(connection);
+    stats.connected=false;
+    stats.pending=0;
+    emit finished(connection.run);
+}
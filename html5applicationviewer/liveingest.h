@@ -0,0 +1,94 @@
+#ifndef LIVEINGEST_H
+#define LIVEINGEST_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+#include "graphdata.h"
+#include "livestream.h"
+#include "sharedring.h"
+
+//Приём записей от симулятора по протоколу LiveStream. Каждое соединение - отдельный прогон
+//"live/<имя>". Принятые записи копятся и раз в KFlushIntervalMs дописываются в GraphData
+//одной пачкой, после чего испускается appended. Пока прогон не забрал KMaxPending записей,
+//сокет не читается: буфер чтения и буфер ядра заполняются, и запись у отправителя блокируется.
+//Для самых быстрых конфигураций симулятор пишет в SharedRing с тем же именем: кольцо
+//опрашивается в том же такте, не больше KMaxPending записей за раз, отставшее отбрасывает писатель
+class LiveIngest : public QObject
+{
+    Q_OBJECT
+public:
+    static const int KFlushIntervalMs = 50;
+    static const int KMaxPending = 65536;//записей на соединение до остановки чтения
+
+    struct Stats
+    {
+        qint64 records;//всего принято
+        double rate;//записей в секунду, сглаженно
+        double latency;//мс от отправки пачки до обновления графиков, последняя пачка
+        double latencyMean;//сглаженно
+        double latencyMax;
+        int pending;
+        int stalls;//сколько раз чтение останавливалось из-за отставания
+        quint64 dropped;//отброшено писателем кольца
+        bool connected;
+        Stats() : records(0), rate(0), latency(0), latencyMean(0), latencyMax(0), pending(0), stalls(0), dropped(0), connected(false) {}
+    };
+
+    LiveIngest(GraphData &data,QObject *parent = 0);
+    ~LiveIngest();
+
+    bool listen(const QString &serverName = LiveStream::DefaultServerName);
+    void stop();//соединения закрываются, прогоны остаются в GraphData
+    bool isListening() const {return m_server.isListening();}
+    QString errorString() const {return m_server.errorString();}
+    QStringList runs() const;
+    Stats stats(const QString &run) const;
+
+signals:
+    void started(const QString &run);//прогон создан в GraphData, записей ещё нет
+    void appended(const QString &run,int first);//first - номер первого нового отсчёта
+    void finished(const QString &run);//отправитель отключился
+
+private slots:
+    void acceptConnections();
+    void readConnection();
+    void connectionClosed();
+    void flush();
+
+private:
+    struct Connection
+    {
+        QLocalSocket *socket;
+        QString run;//пусто до кадра Hello
+        QVector<DataSet> pending;
+        QVector<qint64> sendTimes;//по одной на принятую пачку
+        QElapsedTimer sinceFlush;
+        bool stalled;
+    };
+    GraphData &m_data;
+    QLocalServer m_server;
+    QTimer m_flushTimer;
+    QList<Connection> m_connections;
+    QHash<QString,Stats> m_stats;//и для отключившихся прогонов
+    QString m_serverName;
+    SharedRing m_ring;
+    QString m_ringRun;
+    QElapsedTimer m_ringSinceFlush;
+    int find(QObject *socket) const;
+    bool read(Connection &connection);//false - ошибка протокола
+    int append(Connection &connection);//накопленное - в GraphData, возвращает номер первого отсчёта
+    void flushRing();
+    void delivered(const QString &run,int first,int count,QElapsedTimer &sinceFlush,const QVector<qint64> &sendTimes);
+    void close(int index);
+};
+
+#endif // LIVEINGEST_H
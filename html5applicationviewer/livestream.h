@@ -0,0 +1,81 @@
+#ifndef LIVESTREAM_H
+#define LIVESTREAM_H
+
+#include <QtEndian>
+#include <QByteArray>
+#include <QString>
+#include <chrono>
+
+#include "logformat.h"
+
+//Протокол живой передачи записей от симулятора через локальный сокет (QLocalSocket:
+//Unix domain socket, в Windows - именованный канал). Поток кадров, у каждого заголовок
+//KHeaderSize байт big-endian: magic, тип, длина полезной части, версия записей, время отправки.
+//Hello - имя прогона в UTF-8, Batch - пачка записей в формате лога (LogFormat::encode).
+//Время отправки - мкс системных часов; на одной машине по нему считается задержка до графика
+namespace LiveStream
+{
+enum FrameType{Hello=1,Batch=2};
+
+const quint32 Magic = 0x47564c42;//"GVLB"
+const int HeaderSize = 24;
+const int MaxPayload = 64*1024*1024;
+const char * const DefaultServerName = "graphview-live";
+
+struct Header
+{
+    quint32 type;
+    quint32 length;//байт полезной части
+    quint32 version;//DATASET_VERSION записей пачки
+    qint64 sendTime;
+};
+
+inline qint64 now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+inline void encodeHeader(const Header &header,char *out)
+{
+    qToBigEndian<quint32>(Magic,(uchar*)out);
+    qToBigEndian<quint32>(header.type,(uchar*)out+4);
+    qToBigEndian<quint32>(header.length,(uchar*)out+8);
+    qToBigEndian<quint32>(header.version,(uchar*)out+12);
+    qToBigEndian<qint64>(header.sendTime,(uchar*)out+16);
+}
+
+//false - поток рассинхронизирован или кадр слишком велик, соединение надо закрыть
+inline bool decodeHeader(const char *in,Header &header)
+{
+    if(qFromBigEndian<quint32>((const uchar*)in)!=Magic)
+        return false;
+    header.type=qFromBigEndian<quint32>((const uchar*)in+4);
+    header.length=qFromBigEndian<quint32>((const uchar*)in+8);
+    header.version=qFromBigEndian<quint32>((const uchar*)in+12);
+    header.sendTime=qFromBigEndian<qint64>((const uchar*)in+16);
+    return header.length<=quint32(MaxPayload);
+}
+
+inline QByteArray hello(const QString &run)
+{
+    QByteArray name=run.toUtf8();
+    QByteArray frame(HeaderSize,0);
+    Header header={Hello,quint32(name.size()),DATASET_VERSION,now()};
+    encodeHeader(header,frame.data());
+    return frame+name;
+}
+
+//время отправки ставится в самый последний момент, перед записью в сокет
+inline QByteArray batch(const DataSet *records,int count)
+{
+    const int size=LogFormat::recordSize(DATASET_VERSION);
+    QByteArray frame(HeaderSize+count*size,0);
+    for(int i=0;i<count;i++)
+        LogFormat::encode(records[i],frame.data()+HeaderSize+i*size);
+    Header header={Batch,quint32(count*size),DATASET_VERSION,now()};
+    encodeHeader(header,frame.data());
+    return frame;
+}
+}
+
+#endif // LIVESTREAM_H
@@ -0,0 +1,203 @@
+#include "logcatalog.h"
+#include "logformat.h"
+#include <QtConcurrentMap>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QRegExp>
+#include <QStandardPaths>
+#include <algorithm>
+
+#include "taskscheduler.h"
+
+static const quint32 KCatalogMagic = 0x47564341;//"GVCA"
+static const quint32 KCatalogVersion = 1;
+
+namespace
+{
+//один каталог без вложенных: задачи раздаются пулу потоков по каталогам
+struct ScanDirectory
+{
+    typedef QVector<LogCatalog::Entry> result_type;
+
+    QHash<QString,LogCatalog::Entry> known;
+
+    QVector<LogCatalog::Entry> operator()(const QString &path)
+    {
+        QVector<LogCatalog::Entry> entries;
+        QFileInfoList files=QDir(path).entryInfoList(QStringList("*.dat"),QDir::Files|QDir::NoSymLinks);
+        entries.reserve(files.size());
+        for(int i=0;i<files.size();i++)
+        {
+            LogCatalog::Entry entry;
+            entry.path=files[i].absoluteFilePath();
+            entry.size=files[i].size();
+            entry.modified=files[i].lastModified().toMSecsSinceEpoch();
+            QHash<QString,LogCatalog::Entry>::const_iterator old=known.constFind(entry.path);
+            if(old!=known.constEnd() && old->size==entry.size && old->modified==entry.modified)
+                entry=*old;
+            else if(!LogCatalog::readHeader(entry.path,entry.size,&entry.version,&entry.records))
+                continue;
+            entries.append(entry);
+        }
+        return entries;
+    }
+};
+
+//индексация - упреждающая работа, она не должна задерживать загрузку открытых прогонов
+struct ScanTask
+{
+    typedef LogCatalog::Result result_type;
+    QString root;
+    QHash<QString,LogCatalog::Entry> known;
+    result_type operator()(const TaskScheduler::Token &) const {return LogCatalog::scan(root,known);}
+};
+
+bool pathBefore(const LogCatalog::Entry &a,const LogCatalog::Entry &b)
+{
+    return a.path<b.path;
+}
+}
+
+LogCatalog::LogCatalog(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_watcher,SIGNAL(finished()),SLOT(finished()));
+}
+
+QString LogCatalog::fileName() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::DataLocation)+"/catalog.idx";
+}
+
+bool LogCatalog::load()
+{
+    QFile file(fileName());
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream stream(&file);
+    quint32 magic,version,count;
+    stream>>magic>>version>>count;
+    if(magic!=KCatalogMagic || version!=KCatalogVersion)
+        return false;
+    m_entries.clear();
+    m_entries.reserve(count);
+    for(quint32 i=0;i<count && stream.status()==QDataStream::Ok;i++)
+    {
+        Entry entry;
+        stream>>entry.path>>entry.size>>entry.modified>>entry.version>>entry.records;
+        m_entries.insert(entry.path,entry);
+    }
+    return stream.status()==QDataStream::Ok;
+}
+
+bool LogCatalog::save() const
+{
+    QDir().mkpath(QFileInfo(fileName()).absolutePath());
+    //QSaveFile подменяет файл целиком при commit(): оборванная запись не испортит каталог
+    QSaveFile file(fileName());
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream stream(&file);
+    stream<<KCatalogMagic<<KCatalogVersion<<quint32(m_entries.size());
+    for(QHash<QString,Entry>::const_iterator i=m_entries.constBegin();i!=m_entries.constEnd();++i)
+        stream<<i->path<<i->size<<i->modified<<i->version<<i->records;
+    if(stream.status()!=QDataStream::Ok)
+    {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool LogCatalog::readHeader(const QString &path, qint64 size, quint32 *version, qint64 *records)
+{
+    QFile file(path);
+    uchar header[LogFormat::HeaderSize];
+    if(!file.open(QIODevice::ReadOnly) || file.read((char*)header,LogFormat::HeaderSize)!=LogFormat::HeaderSize)
+        return false;
+    *version=qFromBigEndian<quint32>(header);
+    int recordSize=LogFormat::recordSize(*version);
+    if(recordSize==0)
+        return false;
+    *records=(size-LogFormat::HeaderSize)/recordSize;
+    return true;
+}
+
+void LogCatalog::index(const QString &root)
+{
+    QString path=QDir(root).absolutePath();
+    if(isIndexing())
+    {
+        if(!m_queue.contains(path))
+            m_queue<<path;
+        return;
+    }
+    start(path);
+}
+
+void LogCatalog::start(const QString &root)
+{
+    //снимок каталога передаётся по значению: QHash разделяется без копирования
+    ScanTask task;
+    task.root=root;
+    task.known=m_entries;
+    m_watcher.setFuture(TaskScheduler::run(TaskScheduler::Prefetch,task));
+}
+
+LogCatalog::Result LogCatalog::scan(const QString &root, const QHash<QString,Entry> &known)
+{
+    //обход только каталогов последовательный, файлы каталогов читаются параллельно
+    QStringList directories;
+    directories<<root;
+    QDirIterator it(root,QDir::Dirs|QDir::NoDotAndDotDot|QDir::NoSymLinks,QDirIterator::Subdirectories);
+    while(it.hasNext())
+        directories<<it.next();
+    ScanDirectory functor;
+    functor.known=known;
+    QList<QVector<Entry> > parts=QtConcurrent::blockingMapped(directories,functor);
+    Result result;
+    result.root=root;
+    for(int i=0;i<parts.size();i++)
+        result.entries+=parts[i];
+    return result;
+}
+
+void LogCatalog::finished()
+{
+    Result result=m_watcher.result();
+    //удалённые с диска файлы под этим корнем уходят из каталога
+    const QString prefix=result.root+"/";
+    for(QHash<QString,Entry>::iterator i=m_entries.begin();i!=m_entries.end();)
+    {
+        if(i.key().startsWith(prefix))
+            i=m_entries.erase(i);
+        else
+            ++i;
+    }
+    for(int i=0;i<result.entries.size();i++)
+        m_entries.insert(result.entries[i].path,result.entries[i]);
+    save();
+    emit indexed(result.root,result.entries.size());
+    if(!m_queue.isEmpty())
+        start(m_queue.takeFirst());
+}
+
+QVector<LogCatalog::Entry> LogCatalog::query(const QString &pattern, qint64 minSize, qint64 maxSize) const
+{
+    QRegExp matcher(pattern,Qt::CaseInsensitive,QRegExp::Wildcard);
+    QVector<Entry> result;
+    for(QHash<QString,Entry>::const_iterator i=m_entries.constBegin();i!=m_entries.constEnd();++i)
+    {
+        if(i->size<minSize || (maxSize>=0 && i->size>maxSize))
+            continue;
+        if(matcher.exactMatch(i->path))
+            result.append(*i);
+    }
+    std::sort(result.begin(),result.end(),pathBefore);
+    return result;
+}
@@ -0,0 +1,63 @@
+#ifndef LOGCATALOG_H
+#define LOGCATALOG_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QFutureWatcher>
+
+//Каталог логов на диске: путь, размер, дата, версия и число записей.
+//Каталоги обходятся в фоне параллельно, из файла читается только заголовок;
+//неизменившиеся файлы (тот же размер и дата) не открываются вовсе.
+//Хранится в плоском файле рядом с настройками приложения
+class LogCatalog : public QObject
+{
+    Q_OBJECT
+public:
+    struct Entry
+    {
+        QString path;
+        qint64 size;
+        qint64 modified;//мс от эпохи
+        quint32 version;
+        qint64 records;
+    };
+
+    explicit LogCatalog(QObject *parent = 0);
+
+    bool load();
+    bool save() const;
+    QString fileName() const;
+    int size() const {return m_entries.size();}
+
+    void index(const QString &root);//в фоне, по окончании - indexed()
+    bool isIndexing() const {return m_watcher.isRunning();}
+    //pattern - шаблон пути с * и ?; maxSize<0 - без ограничения
+    QVector<Entry> query(const QString &pattern,qint64 minSize = 0,qint64 maxSize = -1) const;
+
+    static bool readHeader(const QString &path,qint64 size,quint32 *version,qint64 *records);
+
+signals:
+    void indexed(const QString &root,int files);
+
+private slots:
+    void finished();
+
+public:
+    struct Result
+    {
+        QString root;
+        QVector<Entry> entries;
+    };
+    static Result scan(const QString &root,const QHash<QString,Entry> &known);
+
+private:
+    QHash<QString,Entry> m_entries;
+    QFutureWatcher<Result> m_watcher;
+    QStringList m_queue;//корни, ждущие своей очереди
+    void start(const QString &root);
+};
+
+#endif // LOGCATALOG_H
@@ -0,0 +1,270 @@
+#include "logexporter.h"
+#include "floatformat.h"
+#include <QtConcurrentMap>
+#include <QSaveFile>
+#include <QtEndian>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <cstring>
+
+static const char KMagic[] = "GVCOLS01";
+static const int KSliceRows = 4096;//строк CSV на одну задачу форматирования
+static const int KMaxNumberLength = FloatFormat::KMaxFixedLength;
+
+namespace
+{
+struct CsvSlice
+{
+    const QByteArray *run;
+    const QVector<double> *time;
+    const QVector<QVector<float> > *columns;
+    int begin;
+    int end;
+};
+
+//форматирует свой кусок строк в отдельный буфер; порядок кусков сохраняет blockingMapped
+struct CsvFunctor
+{
+    typedef QByteArray result_type;
+
+    QByteArray operator()(const CsvSlice &slice)
+    {
+        const int channels=slice.columns->size();
+        QByteArray buffer;
+        buffer.resize((slice.end-slice.begin)*(slice.run->size()+(channels+1)*KMaxNumberLength+2));
+        char *out=buffer.data();
+        for(int i=slice.begin;i<slice.end;i++)
+        {
+            memcpy(out,slice.run->constData(),slice.run->size());
+            out+=slice.run->size();
+            *out++=',';
+            out+=FloatFormat::fixed((*slice.time)[i],9,out);
+            for(int c=0;c<channels;c++)
+            {
+                *out++=',';
+                float v=(*slice.columns)[c][i];
+                if(FloatFormat::isFinite(v))
+                    out+=FloatFormat::shortest(v,out);
+            }
+            *out++='\n';
+        }
+        buffer.resize(out-buffer.constData());
+        return buffer;
+    }
+};
+
+QByteArray csvField(const QString &text)
+{
+    QByteArray field=text.toUtf8();
+    if(!field.contains(',') && !field.contains('"') && !field.contains('\n'))
+        return field;
+    return '"'+field.replace("\"","\"\"")+'"';
+}
+
+//выгрузку запросил пользователь и ждёт её, но видимые графики важнее
+struct ExportTask
+{
+    typedef LogExporter::Result result_type;
+    LogExporter::Job job;
+    result_type operator()(const TaskScheduler::Token &token) const {return LogExporter::write(job,token);}
+};
+}
+
+LogExporter::LogExporter(GraphData &data, QObject *parent)
+    : QObject(parent)
+    , m_data(data)
+{
+    connect(&m_watcher,SIGNAL(progressValueChanged(int)),SIGNAL(progress(int)));
+    connect(&m_watcher,SIGNAL(finished()),SLOT(written()));
+}
+
+bool LogExporter::start(const QString &fileName, Format format, const QList<int> &runs, const QList<int> &channels, const QStringList &channelNames, double tBegin, double tEnd)
+{
+    if(isRunning())
+        return false;
+    m_result=Result();
+    ExportTask task;
+    task.job.fileName=fileName;
+    task.job.format=format;
+    task.job.tBegin=tBegin;
+    task.job.tEnd=tEnd;
+    for(int k=0;k<channels.size();k++)
+        task.job.channelNames<<channelNames.value(channels[k]);
+    for(int r=0;r<runs.size();r++)
+        task.job.sources<<m_data.snapshot(runs[r],channels);
+    m_watcher.setFuture(TaskScheduler::run(TaskScheduler::VisibleRuns,task));
+    return true;
+}
+
+void LogExporter::cancel()
+{
+    m_watcher.cancel();
+}
+
+void LogExporter::written()
+{
+    //отменённая выгрузка - без текста ошибки, сообщать о ней нечего
+    m_result=m_watcher.isCanceled() ? Result() : m_watcher.result();
+    emit finished(m_result.ok);
+}
+
+LogExporter::Result LogExporter::write(const Job &job, const TaskScheduler::Token &token)
+{
+    Result result;
+    QSaveFile file(job.fileName);
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        result.error=file.errorString();
+        return result;
+    }
+    bool ok;
+    if(job.format==Csv)
+    {
+        QByteArray header="run,time";
+        for(int k=0;k<job.channelNames.size();k++)
+            header+=","+csvField(job.channelNames[k]);
+        ok=file.write(header+"\n")>0;
+    }
+    else
+        ok=file.write(KMagic,8)==8;
+
+    QVector<QPair<int,int> > ranges;
+    qint64 total=0;
+    for(int r=0;r<job.sources.size();r++)
+    {
+        ranges<<GraphData::sourceRange(job.sources[r],job.tBegin,job.tEnd);
+        total+=qMax(0,ranges[r].second-ranges[r].first);
+    }
+    QList<RowGroup> groups;
+    QVector<double> time;
+    QVector<QVector<float> > columns;
+    for(int r=0;r<job.sources.size() && ok;r++)
+    {
+        const QByteArray run=csvField(job.sources[r].name);
+        for(int begin=ranges[r].first;begin<ranges[r].second && ok;begin+=KChunkRows)
+        {
+            //между кусками: отменённая выгрузка оставляет на диске прежний файл
+            if(token.isCancelled())
+            {
+                file.cancelWriting();
+                return result;
+            }
+            int end=qMin(ranges[r].second,begin+KChunkRows);
+            GraphData::readSource(job.sources[r],begin,end,time,columns);
+            if(job.format==Csv)
+                ok=writeCsv(file,run,time,columns);
+            else
+            {
+                RowGroup group;
+                group.run=r;
+                group.rows=time.size();
+                group.offset=file.pos();
+                groups<<group;
+                ok=writeColumnar(file,time,columns);
+            }
+            result.rows+=time.size();
+            token.reportProgress(int(100*result.rows/total),100);
+        }
+    }
+    if(ok && job.format==Columnar)
+        ok=writeFooter(file,job,groups);
+    if(!ok)
+    {
+        result.error=file.errorString();
+        file.cancelWriting();
+        return result;
+    }
+    result.ok=file.commit();
+    if(!result.ok)
+        result.error=file.errorString();
+    return result;
+}
+
+bool LogExporter::writeCsv(QFileDevice &file, const QByteArray &run, const QVector<double> &time, const QVector<QVector<float> > &columns)
+{
+    QList<CsvSlice> slices;
+    for(int begin=0;begin<time.size();begin+=KSliceRows)
+    {
+        CsvSlice slice;
+        slice.run=&run;
+        slice.time=&time;
+        slice.columns=&columns;
+        slice.begin=begin;
+        slice.end=qMin(time.size(),begin+KSliceRows);
+        slices<<slice;
+    }
+    QList<QByteArray> text=QtConcurrent::blockingMapped(slices,CsvFunctor());
+    for(int i=0;i<text.size();i++)
+        if(file.write(text[i])!=text[i].size())
+            return false;
+    return true;
+}
+
+bool LogExporter::writeColumnar(QFileDevice &file, const QVector<double> &time, const QVector<QVector<float> > &columns)
+{
+    const int rows=time.size();
+    QByteArray buffer(rows*sizeof(double),Qt::Uninitialized);
+    uchar *out=(uchar*)buffer.data();
+    for(int i=0;i<rows;i++)
+    {
+        quint64 bits;
+        memcpy(&bits,&time[i],sizeof(bits));
+        qToLittleEndian<quint64>(bits,out+i*sizeof(bits));
+    }
+    if(file.write(buffer)!=buffer.size())
+        return false;
+    buffer.resize(rows*sizeof(float));
+    out=(uchar*)buffer.data();
+    for(int c=0;c<columns.size();c++)
+    {
+        for(int i=0;i<rows;i++)
+        {
+            quint32 bits;
+            memcpy(&bits,&columns[c][i],sizeof(bits));
+            qToLittleEndian<quint32>(bits,out+i*sizeof(bits));
+        }
+        if(file.write(buffer)!=buffer.size())
+            return false;
+    }
+    return true;
+}
+
+bool LogExporter::writeFooter(QFileDevice &file, const Job &job, const QList<RowGroup> &groups)
+{
+    QJsonObject footer;
+    footer["format"]=QString("GVCOLS");
+    footer["version"]=1;
+    footer["byteOrder"]=QString("little");
+    QJsonArray columnList;
+    QJsonObject timeColumn;
+    timeColumn["name"]=QString("time");
+    timeColumn["type"]=QString("float64");
+    columnList.append(timeColumn);
+    for(int k=0;k<job.channelNames.size();k++)
+    {
+        QJsonObject column;
+        column["name"]=job.channelNames[k];
+        column["type"]=QString("float32");
+        columnList.append(column);
+    }
+    footer["columns"]=columnList;
+    QJsonArray runList;
+    for(int r=0;r<job.sources.size();r++)
+        runList.append(job.sources[r].name);
+    footer["runs"]=runList;
+    QJsonArray groupList;
+    for(int i=0;i<groups.size();i++)
+    {
+        QJsonObject group;
+        group["run"]=groups[i].run;
+        group["rows"]=groups[i].rows;
+        group["offset"]=double(groups[i].offset);
+        groupList.append(group);
+    }
+    footer["rowGroups"]=groupList;
+    QByteArray json=QJsonDocument(footer).toJson(QJsonDocument::Compact);
+    uchar length[8];
+    qToLittleEndian<quint64>(json.size(),length);
+    return file.write(json)==json.size() && file.write((const char*)length,8)==8 && file.write(KMagic,8)==8;
+}
@@ -0,0 +1,82 @@
+#ifndef LOGEXPORTER_H
+#define LOGEXPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QFile>
+#include <QFutureWatcher>
+
+#include "graphdata.h"
+#include "taskscheduler.h"
+
+//Потоковая выгрузка прогонов в CSV или в столбцовый двоичный формат.
+//Данные читаются кусками по KChunkRows строк, поэтому память не зависит от длины лога.
+//Выгрузка идёт фоновой задачей планировщика по снимку прогонов, взятому при запуске:
+//прогоны можно закрывать, не дожидаясь её конца. Ход - progress(), итог - finished()
+//
+//Столбцовый формат (.gvc), все числа little-endian:
+//  "GVCOLS01"
+//  группы строк: каждый столбец группы подряд (time - float64, каналы - float32)
+//  описание в JSON: столбцы, прогоны, группы строк (прогон, число строк, смещение)
+//  quint64 длина описания
+//  "GVCOLS01"
+class LogExporter : public QObject
+{
+    Q_OBJECT
+public:
+    enum Format{Csv,Columnar};
+
+    static const int KChunkRows = 65536;
+
+    explicit LogExporter(GraphData &data,QObject *parent = 0);
+
+    //false - предыдущая выгрузка ещё идёт
+    bool start(const QString &fileName,Format format,const QList<int> &runs,const QList<int> &channels,const QStringList &channelNames,double tBegin,double tEnd);
+    void cancel();//незаконченный файл не сохраняется
+    bool isRunning() const {return m_watcher.isRunning();}
+    QString errorString() const {return m_result.error;}
+    quint64 rowsWritten() const {return m_result.rows;}
+
+    struct Job
+    {
+        QString fileName;
+        Format format;
+        QList<GraphData::Source> sources;
+        QStringList channelNames;//имена выгружаемых каналов по порядку
+        double tBegin;
+        double tEnd;
+    };
+    struct Result
+    {
+        bool ok;
+        QString error;
+        quint64 rows;
+        Result() : ok(false), rows(0) {}
+    };
+    static Result write(const Job &job,const TaskScheduler::Token &token);
+
+signals:
+    void progress(int percent);//0..100
+    void finished(bool ok);
+
+private slots:
+    void written();
+
+private:
+    struct RowGroup
+    {
+        int run;
+        int rows;
+        qint64 offset;
+    };
+    GraphData &m_data;
+    QFutureWatcher<Result> m_watcher;
+    Result m_result;
+    static bool writeCsv(QFileDevice &file,const QByteArray &run,const QVector<double> &time,const QVector<QVector<float> > &columns);
+    static bool writeColumnar(QFileDevice &file,const QVector<double> &time,const QVector<QVector<float> > &columns);
+    static bool writeFooter(QFileDevice &file,const Job &job,const QList<RowGroup> &groups);
+};
+
+#endif // LOGEXPORTER_H
@@ -0,0 +1,117 @@
+#include "logformat.h"
+
+static const double KMaxTimestep = 1.0;//с; шаг физики симулятора на порядки меньше
+
+namespace
+{
+inline void writeDouble(char *&out,double value)
+{
+    quint64 bits;
+    memcpy(&bits,&value,sizeof(bits));
+    qToBigEndian<quint64>(bits,(uchar*)out);
+    out+=8;
+}
+
+inline bool isUnitQuaternion(const char *in)
+{
+    double norm=0;
+    for(int i=0;i<4;i++)
+    {
+        double v=LogFormat::readDouble(in+8*i);
+        norm+=v*v;
+    }
+    return qAbs(norm-1)<=0.01;//NaN не проходит
+}
+
+inline void writeBody(char *&out,const BodyData &body)
+{
+    writeDouble(out,body.p.x());
+    writeDouble(out,body.p.y());
+    writeDouble(out,body.p.z());
+    writeDouble(out,body.q.scalar());
+    writeDouble(out,body.q.x());
+    writeDouble(out,body.q.y());
+    writeDouble(out,body.q.z());
+}
+
+inline float takeFloat(const char *&in)
+{
+    float value=float(LogFormat::readDouble(in));
+    in+=8;
+    return value;
+}
+
+inline void readBody(const char *&in,BodyData &body)
+{
+    float x=takeFloat(in);
+    float y=takeFloat(in);
+    float z=takeFloat(in);
+    body.p=QVector3D(x,y,z);
+    float scalar=takeFloat(in);
+    x=takeFloat(in);
+    y=takeFloat(in);
+    z=takeFloat(in);
+    body.q=QQuaternion(scalar,x,y,z);
+}
+}
+
+int LogFormat::recordSize(quint32 version)
+{
+    switch(version)
+    {
+    case 0x1:return VehicleP;
+    case 0x2:return VehicleP+5*BodySize;
+    default:return 0;
+    }
+}
+
+void LogFormat::encode(const DataSet &dataset, char *out)
+{
+    memcpy(out,dataset.camera_pixels,CAMERA_FRAME_LEN);
+    out+=CAMERA_FRAME_LEN;
+    writeBody(out,dataset.camera);
+    writeDouble(out,dataset.control_interval);
+    writeDouble(out,dataset.current_wheel_angle);
+    writeDouble(out,dataset.desired_wheel_angle);
+    writeDouble(out,dataset.physics_timestep);
+    writeDouble(out,dataset.wheel_power_l);
+    writeDouble(out,dataset.wheel_power_r);
+    qToBigEndian<qint32>(dataset.line_position,(uchar*)out);
+    out+=4;
+    writeBody(out,dataset.vehicle);
+    for(int i=0;i<4;i++)
+        writeBody(out,dataset.wheels[i]);
+}
+
+void LogFormat::decode(const char *in, quint32 version, DataSet &dataset)
+{
+    memcpy(dataset.camera_pixels,in,CAMERA_FRAME_LEN);
+    in+=CAMERA_FRAME_LEN;
+    readBody(in,dataset.camera);
+    dataset.control_interval=takeFloat(in);
+    dataset.current_wheel_angle=takeFloat(in);
+    dataset.desired_wheel_angle=takeFloat(in);
+    dataset.physics_timestep=takeFloat(in);
+    dataset.wheel_power_l=takeFloat(in);
+    dataset.wheel_power_r=takeFloat(in);
+    dataset.line_position=readInt(in);
+    in+=4;
+    if(version<0x2)
+        return;
+    readBody(in,dataset.vehicle);
+    for(int i=0;i<4;i++)
+        readBody(in,dataset.wheels[i]);
+}
+
+bool LogFormat::isPlausible(const char *in, quint32 version)
+{
+    double dt=readDouble(in+PhysicsTimestep);
+    if(!(dt>=0 && dt<KMaxTimestep))
+        return false;
+    qint32 line=readInt(in+LinePosition);
+    if(line<-1 || line>=CAMERA_FRAME_LEN)
+        return false;
+    if(!isUnitQuaternion(in+CameraQ))
+        return false;
+    return version<0x2 || isUnitQuaternion(in+VehicleP+CameraQ-CameraP);
+}
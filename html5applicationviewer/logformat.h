@@ -0,0 +1,40 @@
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+
+#include <QtEndian>
+#include <cstring>
+
+#include "common.h"
+
+//Двоичный формат записи лога. Совпадает с тем, что пишет QDataStream
+//(big-endian, float как double), поэтому старые логи читаются без изменений.
+//Поля версии 1 идут первыми, состояния корпуса и колёс версии 2 дописаны в конец,
+//так что смещения каналов от версии не зависят
+namespace LogFormat
+{
+enum Field{CameraPixels=0,CameraP=128,CameraQ=152,ControlInterval=184,CurrentWheelAngle=192,DesiredWheelAngle=200,PhysicsTimestep=208,WheelPowerL=216,WheelPowerR=224,LinePosition=232,VehicleP=236};
+
+const int HeaderSize = 4;
+const int BodySize = 56;
+
+int recordSize(quint32 version);
+void encode(const DataSet &dataset,char *out);
+void decode(const char *in,quint32 version,DataSet &dataset);
+//быстрая проверка правдоподобия записи: по ней ищется граница записи после повреждения
+bool isPlausible(const char *in,quint32 version);
+
+inline double readDouble(const char *in)
+{
+    quint64 bits=qFromBigEndian<quint64>((const uchar*)in);
+    double value;
+    memcpy(&value,&bits,sizeof(value));
+    return value;
+}
+
+inline qint32 readInt(const char *in)
+{
+    return qFromBigEndian<qint32>((const uchar*)in);
+}
+}
+
+#endif // LOGFORMAT_H
@@ -1,14 +1,56 @@
 #include "logger.h"
+#include "logformat.h"
+#include "sharedring.h"
+#include <QThread>
+#include <QElapsedTimer>
+
+static const int KBatchRecords = 256;
+static const int KFlushIntervalMs = 500;
+static const int KIdleSleepUs = 200;
+static const int KResyncRecords = 3;//столько записей подряд должны быть правдоподобны после пропуска
+
+class LoggerWriterThread : public QThread
+{
+public:
+    LoggerWriterThread(Logger *logger) : m_logger(logger) {}
+protected:
+    void run() {m_logger->drainQueue();}
+private:
+    Logger *m_logger;
+};
 
 Logger::Logger ()
     : m_file(0)
     , m_stream(0)
     , m_mode(Logger::Closed)
     , m_written(0)
+    , m_version(0)
+    , m_recordSize(0)
+    , m_bufferPos(0)
+    , m_bufferOffset(0)
+    , m_recovery(false)
+    , m_pending(0)
+    , m_failed(false)
+    , m_writeMode(Logger::Synchronous)
+    , m_policy(Logger::Block)
+    , m_queueCapacity(4096)
+    , m_queue(0)
+    , m_writer(0)
+    , m_stopping(false)
+    , m_dropped(0)
+    , m_blocked(0)
+    , m_ring(0)
 {
 
 }
 
+void Logger::setWriteMode(WriteMode mode, BackpressurePolicy policy, int queueCapacity)
+{
+    m_writeMode=mode;
+    m_policy=policy;
+    m_queueCapacity=queueCapacity;
+}
+
 void Logger::setFileName(const QString &filename)
 {
     if(!m_file)
@@ -26,19 +68,80 @@ bool Logger::beginWrite()
         m_mode=Logger::Write;
         m_stream.setDevice(m_file);
         m_stream<<DATASET_VERSION;
+        m_version=DATASET_VERSION;
+        m_recordSize=LogFormat::recordSize(m_version);
+        m_buffer.resize(KBatchRecords*m_recordSize);
+        m_pending=0;
+        m_failed=false;
+        m_dropped=0;
+        m_blocked=0;
+        if(m_writeMode==Logger::Asynchronous)
+        {
+            m_queue=new SpscRingBuffer<DataSet>(m_queueCapacity);
+            m_stopping=false;
+            m_writer=new LoggerWriterThread(this);
+            m_writer->start();
+        }
         return true;
     }
     else
         return false;
 }
 
-quint64 Logger::endWrite()
+Logger::WriteStats Logger::endWrite()
 {
+    if(m_writer)
+    {
+        m_stopping=true;
+        m_writer->wait();
+        delete m_writer;
+        delete m_queue;
+        m_writer=0;
+        m_queue=0;
+    }
+    if(m_mode==Logger::Write)
+        flushBuffer();
     m_file->flush();
     m_file->close();
     m_stream.setDevice(0);
     m_mode=Logger::Closed;
-    return m_written;
+    m_buffer.clear();
+    WriteStats stats;
+    stats.written=m_written;
+    stats.dropped=m_dropped;
+    stats.blocked=m_blocked;
+    return stats;
+}
+
+void Logger::drainQueue()
+{
+    QVector<DataSet> batch(KBatchRecords);
+    QElapsedTimer sinceFlush;
+    sinceFlush.start();
+    for(;;)
+    {
+        //флаг читается до извлечения, чтобы не потерять записи, добавленные перед остановкой
+        bool stopping=m_stopping;
+        int count=m_queue->pop(batch.data(),KBatchRecords);
+        if(count>0)
+        {
+            for(int i=0;i<count;i++)
+                LogFormat::encode(batch[i],m_buffer.data()+i*m_recordSize);
+            m_pending=count;
+            flushBuffer();
+        }
+        if(sinceFlush.elapsed()>=KFlushIntervalMs)
+        {
+            m_file->flush();
+            sinceFlush.restart();
+        }
+        if(count==0)
+        {
+            if(stopping)
+                break;
+            QThread::usleep(KIdleSleepUs);
+        }
+    }
 }
 
 bool Logger::beginRead()
@@ -49,13 +152,21 @@ bool Logger::beginRead()
         m_stream.setDevice(m_file);
         quint32 header=0;
         m_stream>>header;
-        if(header!=DATASET_VERSION)
+        m_damage=DamageReport();
+        if(LogFormat::recordSize(header)==0 && m_recovery)
+            header=guessVersion();
+        if(LogFormat::recordSize(header)==0)
         {
             m_stream.setDevice(0);
             m_file->close();
             log("Bad log file or different version.");
             return false;
         }
+        m_version=header;
+        m_recordSize=LogFormat::recordSize(header);
+        m_buffer.clear();
+        m_bufferPos=0;
+        m_bufferOffset=LogFormat::HeaderSize;
         m_mode=Logger::Read;
         return true;
     }
@@ -65,17 +176,96 @@ bool Logger::beginRead()
 
 quint64 Logger::endRead()
 {
-    return endWrite();
+    return endWrite().written;
 }
 
 bool Logger::canRead()
 {
-    return !(m_stream.status()==QDataStream::ReadPastEnd || m_stream.status()==QDataStream::ReadCorruptData || m_stream.atEnd());
+    if(m_mode!=Logger::Read)
+        return false;
+    if(m_bufferPos+m_recordSize>m_buffer.size() && !fillBuffer())
+    {
+        if(m_recovery)
+            m_damage.truncatedBytes=m_buffer.size()-m_bufferPos;
+        return false;
+    }
+    //проверка - несколько сравнений на запись, целый файл читается с той же скоростью
+    if(m_recovery && !LogFormat::isPlausible(m_buffer.constData()+m_bufferPos,m_version))
+        return resync();
+    return true;
+}
+
+bool Logger::resync()
+{
+    const qint64 start=m_bufferOffset+m_bufferPos;
+    for(;;)
+    {
+        m_bufferPos++;
+        if(m_bufferPos+KResyncRecords*m_recordSize>m_buffer.size())
+            fillBuffer();
+        //у конца файла хватает и меньшего числа записей
+        const int count=qMin(KResyncRecords,(m_buffer.size()-m_bufferPos)/m_recordSize);
+        if(count==0)
+        {
+            m_damage.regions.append(qMakePair(start,m_bufferOffset+m_buffer.size()-start));
+            m_damage.skippedBytes+=m_bufferOffset+m_buffer.size()-start;
+            m_bufferPos=m_buffer.size();
+            return false;
+        }
+        bool plausible=true;
+        for(int i=0;i<count && plausible;i++)
+            plausible=LogFormat::isPlausible(m_buffer.constData()+m_bufferPos+i*m_recordSize,m_version);
+        if(plausible)
+        {
+            m_damage.regions.append(qMakePair(start,m_bufferOffset+m_bufferPos-start));
+            m_damage.skippedBytes+=m_bufferOffset+m_bufferPos-start;
+            return true;
+        }
+    }
+}
+
+quint32 Logger::guessVersion()
+{
+    //выбирается версия, при которой первые записи правдоподобны; текущая проверяется первой
+    const quint32 versions[2]={DATASET_VERSION,0x1};
+    for(int v=0;v<2;v++)
+    {
+        const int size=LogFormat::recordSize(versions[v]);
+        QByteArray head=m_file->peek(qint64(KResyncRecords)*size);
+        const int count=head.size()/size;
+        bool plausible=count>0;
+        for(int i=0;i<count && plausible;i++)
+            plausible=LogFormat::isPlausible(head.constData()+i*size,versions[v]);
+        if(plausible)
+        {
+            m_damage.headerGuessed=true;
+            return versions[v];
+        }
+    }
+    return 0;
 }
 
 bool Logger::canWrite()
 {
-    return !(m_stream.status()==QDataStream::WriteFailed);
+    return !m_failed;
+}
+
+bool Logger::flushBuffer()
+{
+    qint64 size=qint64(m_pending)*m_recordSize;
+    if(size>0 && m_file->write(m_buffer.constData(),size)!=size)
+        m_failed=true;
+    m_pending=0;
+    return !m_failed;
+}
+
+bool Logger::fillBuffer()
+{
+    m_bufferOffset+=m_bufferPos;
+    m_buffer.remove(0,m_bufferPos);
+    m_bufferPos=0;
+    m_buffer.append(m_file->read(qint64(KBatchRecords)*m_recordSize));
+    return m_buffer.size()>=m_recordSize;
 }
 
 Logger & Logger::operator <<(DataSet &dataset)
@@ -85,18 +275,31 @@ Logger & Logger::operator <<(DataSet &dataset)
         log("Can't write. Wrong openMode or closed file.");
         return *this;
     }
-    m_stream.writeRawData((char *)dataset.camera_pixels,CAMERA_FRAME_LEN);
-    m_stream<<dataset.camera.p;
-    m_stream<<dataset.camera.q;
-    m_stream<<dataset.control_interval;
-    m_stream<<dataset.current_wheel_angle;
-    m_stream<<dataset.desired_wheel_angle;
-    m_stream<<dataset.physics_timestep;
-    m_stream<<dataset.wheel_power_l;
-    m_stream<<dataset.wheel_power_r;
-    m_stream<<dataset.line_position;
-
+    //просмотрщик не задерживает запись: при полном кольце запись туда отбрасывается
+    if(m_ring)
+        m_ring->push(dataset);
+    if(m_queue)
+    {
+        //симулятор только копирует запись в очередь, диск обслуживает фоновый поток
+        if(!m_queue->push(dataset))
+        {
+            if(m_policy==Logger::DropNewest)
+            {
+                m_dropped++;
+                return *this;
+            }
+            m_blocked++;
+            while(!m_queue->push(dataset))
+                QThread::yieldCurrentThread();
+        }
+        m_written++;
+        return *this;
+    }
+    LogFormat::encode(dataset,m_buffer.data()+m_pending*m_recordSize);
+    m_pending++;
     m_written++;
+    if(m_pending==KBatchRecords)
+        flushBuffer();
 
     return *this;
 }
@@ -108,18 +311,17 @@ Logger &Logger::operator >>(DataSet &dataset)
         log("Can't read. Wrong openMode or closed file.");
         return *this;
     }
-    m_stream.readRawData((char *)dataset.camera_pixels,CAMERA_FRAME_LEN);
-    m_stream>>dataset.camera.p;
-    m_stream>>dataset.camera.q;
-    m_stream>>dataset.control_interval;
-    m_stream>>dataset.current_wheel_angle;
-    m_stream>>dataset.desired_wheel_angle;
-    m_stream>>dataset.physics_timestep;
-    m_stream>>dataset.wheel_power_l;
-    m_stream>>dataset.wheel_power_r;
-    m_stream>>dataset.line_position;
-    if(m_stream.status()==QDataStream::ReadCorruptData)
-        throw CorruptedStructureException();
+    //недописанная последняя запись (например, симулятор упал)
+    if(!canRead())
+    {
+        if(m_bufferPos<m_buffer.size() && !m_recovery)
+            throw CorruptedStructureException();
+        log("Can't read. End of file.");
+        return *this;
+    }
+    LogFormat::decode(m_buffer.constData()+m_bufferPos,m_version,dataset);
+    m_bufferPos+=m_recordSize;
+    m_damage.records++;
     return *this;
 }
 
@@ -131,6 +333,9 @@ void Logger::log(QString text)
 
 Logger::~Logger()
 {
-    m_file->close();
+    if(m_mode==Logger::Write)
+        endWrite();
+    if(m_file)
+        m_file->close();
     delete m_file;
 }
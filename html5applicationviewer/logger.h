@@ -5,9 +5,14 @@
 #include <QDataStream>
 #include <QVector>
 #include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QPair>
 #include <exception>
+#include <atomic>
 
 #include "common.h"
+#include "spscringbuffer.h"
 
 class Logger
 {
@@ -15,19 +20,49 @@ class Logger
 public:
 
     enum Mode{Closed,Read,Write};
+    enum WriteMode{Synchronous,Asynchronous};
+    enum BackpressurePolicy{Block,DropNewest};//что делать, если очередь асинхронной записи полна
+
+    //итог записи; приводится к quint64 (число записанных записей) как раньше
+    struct WriteStats
+    {
+        quint64 written;
+        quint64 dropped;
+        quint64 blocked;
+        operator quint64() const {return written;}
+    };
+
+    //что пропущено при чтении в режиме восстановления
+    struct DamageReport
+    {
+        quint64 records;//прочитано записей
+        qint64 skippedBytes;
+        QList<QPair<qint64,qint64> > regions;//смещение в файле и длина пропущенного участка
+        qint64 truncatedBytes;//недописанная последняя запись
+        bool headerGuessed;//заголовок повреждён, версия определена по записям
+        DamageReport() : records(0), skippedBytes(0), truncatedBytes(0), headerGuessed(false) {}
+        bool isClean() const {return regions.isEmpty() && truncatedBytes==0 && !headerGuessed;}
+    };
 
     Logger();
 
     void setFileName(const QString &filename);
+    void setWriteMode(WriteMode mode,BackpressurePolicy policy=Block,int queueCapacity=4096);
+    //в режиме восстановления повреждённые участки пропускаются вместо исключения
+    void setRecovery(bool enabled) {m_recovery=enabled;}
+    //каждая записанная запись дублируется в кольцо для живого просмотра; кольцо создаёт вызывающий
+    void setLiveRing(class SharedRing *ring) {m_ring=ring;}
 
     bool beginWrite();
-    quint64 endWrite();
+    WriteStats endWrite();
     bool canWrite();
 
     bool beginRead();
     quint64 endRead();
     bool canRead();
 
+    quint32 version() {return m_version;}
+    const DamageReport &damage() const {return m_damage;}
 
     Mode mode() {return m_mode;}
 
@@ -38,11 +73,35 @@ public:
 
     class CorruptedStructureException {};
 private:
+    friend class LoggerWriterThread;
 
     QFile * m_file;
     QDataStream m_stream;
     Mode m_mode;
     quint64 m_written;
+    quint32 m_version;
+    int m_recordSize;
+    QByteArray m_buffer;//записи копятся здесь и пишутся/читаются пачками
+    int m_bufferPos;
+    qint64 m_bufferOffset;//смещение начала буфера в файле
+    bool m_recovery;
+    DamageReport m_damage;
+    int m_pending;
+    std::atomic<bool> m_failed;
+    WriteMode m_writeMode;
+    BackpressurePolicy m_policy;
+    int m_queueCapacity;
+    SpscRingBuffer<DataSet> *m_queue;
+    class LoggerWriterThread *m_writer;
+    std::atomic<bool> m_stopping;
+    quint64 m_dropped;
+    quint64 m_blocked;
+    class SharedRing *m_ring;
+    bool flushBuffer();
+    bool fillBuffer();
+    bool resync();//поиск следующей правдоподобной границы записи
+    quint32 guessVersion();
+    void drainQueue();//цикл фонового потока записи
     void log(QString text);
 
 };
@@ -0,0 +1,243 @@
+#include "lograngereader.h"
+#include "logformat.h"
+#include <qnumeric.h>
+#include <algorithm>
+
+static const int KColumnOffset[LogRangeReader::ColumnCount]={
+    LogFormat::ControlInterval,LogFormat::CurrentWheelAngle,LogFormat::DesiredWheelAngle,
+    LogFormat::PhysicsTimestep,LogFormat::WheelPowerL,LogFormat::WheelPowerR,
+    LogFormat::LinePosition,LogFormat::CameraP,LogFormat::CameraP+16};
+
+LogRangeReader::LogRangeReader()
+    : m_data(0)
+    , m_version(0)
+    , m_recordSize(0)
+    , m_count(0)
+{
+
+}
+
+LogRangeReader::~LogRangeReader()
+{
+    close();
+}
+
+bool LogRangeReader::open(const QString &fileName)
+{
+    close();
+    m_file.setFileName(fileName);
+    if(!m_file.open(QIODevice::ReadOnly) || m_file.size()<LogFormat::HeaderSize)
+    {
+        close();
+        return false;
+    }
+    m_data=m_file.map(0,m_file.size());
+    if(!m_data)
+    {
+        close();
+        return false;
+    }
+    m_version=qFromBigEndian<quint32>(m_data);
+    m_recordSize=LogFormat::recordSize(m_version);
+    if(m_recordSize==0)
+    {
+        close();
+        return false;
+    }
+    //недописанная последняя запись отбрасывается, как и в Logger
+    m_count=int((m_file.size()-LogFormat::HeaderSize)/m_recordSize);
+    return true;
+}
+
+bool LogRangeReader::extendIndex(QVector<double> &time, int count) const
+{
+    const int begin=time.size();
+    const int end=qMin(m_count,begin+count);
+    double t=0;
+    if(begin>0)
+    {
+        float dt=value(begin-1,PhysicsTimestep);
+        t=time.last()+(qIsFinite(dt) && dt>0 ? dt : 0);
+    }
+    time.resize(end);
+    for(int i=begin;i<end;i++)
+    {
+        //смещения полей фиксированы, поэтому повреждённый файл читается только через Logger с восстановлением
+        if(!LogFormat::isPlausible((const char*)m_data+LogFormat::HeaderSize+qint64(i)*m_recordSize,m_version))
+        {
+            time.resize(i);
+            return false;
+        }
+        time[i]=t;
+        float dt=value(i,PhysicsTimestep);
+        if(qIsFinite(dt) && dt>0)
+            t+=dt;
+    }
+    return true;
+}
+
+void LogRangeReader::setIndex(const QVector<double> &time)
+{
+    if(time.size()==m_count)
+        m_time=time;
+}
+
+LogRangeReader::Window LogRangeReader::sample(int columns, int stride) const
+{
+    Window window;
+    stride=qMax(1,stride);
+    const int count=(m_count+stride-1)/stride;
+    window.downsampled=stride>1;
+    window.time.resize(count);
+    for(int c=0;c<ColumnCount;c++)
+        if(columns>>c&1)
+            window.columns[c].resize(count);
+    double t=0;
+    for(int k=0;k<count;k++)
+    {
+        const int i=k*stride;
+        if(isIndexed())
+            t=m_time[i];
+        window.time[k]=t;
+        for(int c=0;c<ColumnCount;c++)
+            if(columns>>c&1)
+                window.columns[c][k]=value(i,c);
+        //шаг выбранной записи считается типичным для всего интервала до следующей
+        float dt=value(i,PhysicsTimestep);
+        if(qIsFinite(dt) && dt>0)
+            t+=double(dt)*stride;
+    }
+    return window;
+}
+
+void LogRangeReader::close()
+{
+    if(m_data)
+        m_file.unmap(const_cast<uchar*>(m_data));
+    m_data=0;
+    m_file.close();
+    m_time.clear();
+    m_version=0;
+    m_recordSize=0;
+    m_count=0;
+}
+
+float LogRangeReader::value(int record, int column) const
+{
+    const char *in=(const char*)m_data+LogFormat::HeaderSize+qint64(record)*m_recordSize+KColumnOffset[column];
+    if(column==LinePosition)
+    {
+        qint32 position=LogFormat::readInt(in);
+        return position==-1 ? qQNaN() : float(position);
+    }
+    return float(LogFormat::readDouble(in));
+}
+
+const uchar *LogRangeReader::cameraFrame(int record) const
+{
+    return m_data+LogFormat::HeaderSize+qint64(record)*m_recordSize+LogFormat::CameraPixels;
+}
+
+int LogRangeReader::firstDamaged(int begin, int end) const
+{
+    for(int i=begin;i<end;i++)
+        if(!LogFormat::isPlausible((const char*)m_data+LogFormat::HeaderSize+qint64(i)*m_recordSize,m_version))
+            return i;
+    return end;
+}
+
+QPair<int,int> LogRangeReader::recordRange(double tBegin, double tEnd) const
+{
+    const int begin=std::lower_bound(m_time.constBegin(),m_time.constEnd(),tBegin)-m_time.constBegin();
+    const int end=std::upper_bound(m_time.constBegin()+begin,m_time.constEnd(),tEnd)-m_time.constBegin();
+    return qMakePair(begin,end);
+}
+
+LogRangeReader::Window LogRangeReader::readRecords(int columns, int begin, int end) const
+{
+    Window window;
+    window.downsampled=false;
+    const int count=qMax(0,end-begin);
+    window.time=m_time.mid(begin,count);
+    for(int c=0;c<ColumnCount;c++)
+        if(columns>>c&1)
+            window.columns[c].resize(count);
+    for(int i=0;i<count;i++)
+        for(int c=0;c<ColumnCount;c++)
+            if(columns>>c&1)
+                window.columns[c][i]=value(begin+i,c);
+    return window;
+}
+
+LogRangeReader::Window LogRangeReader::read(int columns, double tBegin, double tEnd, int maxPoints) const
+{
+    const QPair<int,int> range=recordRange(tBegin,tEnd);
+    const int begin=range.first;
+    const int count=range.second-range.first;
+    if(count<=maxPoints || maxPoints<2)
+        return readRecords(columns,begin,range.second);
+
+    Window window;
+    //по две точки на корзину: минимум и максимум в порядке появления, чтобы не терять выбросы.
+    //Положение берётся из тех же записей, что и время, а не min/max - иначе траектория исказится
+    window.downsampled=true;
+    const int buckets=maxPoints/2;
+    window.time.resize(2*buckets);
+    for(int c=0;c<ColumnCount;c++)
+        if(columns>>c&1)
+            window.columns[c].resize(2*buckets);
+    for(int b=0;b<buckets;b++)
+    {
+        const int first=begin+int(qint64(count)*b/buckets);
+        const int last=begin+int(qint64(count)*(b+1)/buckets);
+        const int middle=(first+last)/2;
+        window.time[2*b]=m_time[first];
+        window.time[2*b+1]=m_time[middle];
+        int minAt[ColumnCount];
+        int maxAt[ColumnCount];
+        float mn[ColumnCount];
+        float mx[ColumnCount];
+        std::fill(minAt,minAt+ColumnCount,-1);
+        std::fill(maxAt,maxAt+ColumnCount,-1);
+        //записи перебираются по порядку, чтобы каждая страница файла читалась один раз
+        for(int i=first;i<last;i++)
+        {
+            for(int c=0;c<PositionX;c++)
+            {
+                if(!(columns>>c&1))
+                    continue;
+                float v=value(i,c);
+                if(!qIsFinite(v))
+                    continue;
+                if(minAt[c]<0 || v<mn[c])
+                {
+                    mn[c]=v;
+                    minAt[c]=i;
+                }
+                if(maxAt[c]<0 || v>mx[c])
+                {
+                    mx[c]=v;
+                    maxAt[c]=i;
+                }
+            }
+        }
+        for(int c=0;c<ColumnCount;c++)
+        {
+            if(!(columns>>c&1))
+                continue;
+            if(c>=PositionX)
+            {
+                window.columns[c][2*b]=value(first,c);
+                window.columns[c][2*b+1]=value(middle,c);
+            }
+            else if(minAt[c]<0)
+                window.columns[c][2*b]=window.columns[c][2*b+1]=qQNaN();
+            else
+            {
+                window.columns[c][2*b]=minAt[c]<=maxAt[c] ? mn[c] : mx[c];
+                window.columns[c][2*b+1]=minAt[c]<=maxAt[c] ? mx[c] : mn[c];
+            }
+        }
+    }
+    return window;
+}
@@ -0,0 +1,64 @@
+#ifndef LOGRANGEREADER_H
+#define LOGRANGEREADER_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QPair>
+
+//Чтение окна по времени из большого лога: файл отображается в память,
+//записи фиксированной длины адресуются напрямую, а декодируются только нужные поля.
+//Время записи - префиксная сумма physics_timestep, как в GraphData::addTo.
+//Открытие не читает записи; индекс времени строится отдельно (extendIndex), обычно в фоне
+class LogRangeReader
+{
+public:
+    enum Column{ControlInterval,CurrentWheelAngle,DesiredWheelAngle,PhysicsTimestep,WheelPowerL,WheelPowerR,LinePosition,PositionX,PositionZ,ColumnCount};
+
+    struct Window
+    {
+        QVector<double> time;
+        QVector<float> columns[ColumnCount];//незапрошенные столбцы пустые
+        bool downsampled;
+    };
+
+    LogRangeReader();
+    ~LogRangeReader();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const {return m_data!=0;}
+    int recordCount() const {return m_count;}
+    bool isIndexed() const {return m_count>0 && m_time.size()==m_count;}
+    double duration() const {return m_time.isEmpty() ? 0 : m_time.last();}
+
+    //индекс строится порциями по count записей, чтобы долгий проход можно было прервать;
+    //false - встретилась повреждённая запись
+    bool extendIndex(QVector<double> &time,int count) const;
+    void setIndex(const QVector<double> &time);
+    const QVector<double> &timeIndex() const {return m_time;}
+    //каждая stride-я запись; до построения индекса время оценивается по выбранным записям
+    Window sample(int columns,int stride) const;
+
+    //дальше нужен индекс времени
+    //columns - маска (1<<Column); больше maxPoints записей сводится к min/max по корзинам
+    Window read(int columns,double tBegin,double tEnd,int maxPoints) const;
+    //записи [begin,end) без прореживания, для потоковой обработки кусками
+    Window readRecords(int columns,int begin,int end) const;
+    QPair<int,int> recordRange(double tBegin,double tEnd) const;
+    //CAMERA_FRAME_LEN байт кадра камеры прямо в отображённом файле
+    const uchar *cameraFrame(int record) const;
+    //первая повреждённая запись в [begin,end), end - если таких нет
+    int firstDamaged(int begin,int end) const;
+
+private:
+    QFile m_file;
+    const uchar *m_data;
+    quint32 m_version;
+    int m_recordSize;
+    int m_count;
+    QVector<double> m_time;//время каждой записи
+    float value(int record,int column) const;
+};
+
+#endif // LOGRANGEREADER_H
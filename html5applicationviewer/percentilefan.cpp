@@ -0,0 +1,201 @@
+#include "percentilefan.h"
+#include <QtConcurrentMap>
+#include <qnumeric.h>
+#include <algorithm>
+
+#include "taskscheduler.h"
+
+static const int KChunkPoints = 64;//узлов сетки в одной параллельной задаче
+static const float KPercents[PercentileFan::LevelCount] = {5,25,50,75,95};
+
+namespace
+{
+//копии общие с GraphData до первого изменения
+struct FanSource
+{
+    QVector<double> time;
+    QVector<float> values;
+};
+
+struct FanJob
+{
+    const QVector<FanSource> *sources;
+    const TaskScheduler::Token *token;
+    double tBegin;
+    double step;
+    int begin;
+    int end;
+};
+
+//процентиль по упорядоченным значениям с интерполяцией между соседними
+float quantile(const QVector<float> &sorted,float percent)
+{
+    if(sorted.isEmpty())
+        return float(qQNaN());
+    const double position=percent/100*(sorted.size()-1);
+    const int lower=int(position);
+    if(lower+1>=sorted.size())
+        return sorted[lower];
+    return float(sorted[lower]+(position-lower)*(sorted[lower+1]-sorted[lower]));
+}
+
+struct FanFunctor
+{
+    typedef PercentileFan::Band result_type;
+
+    PercentileFan::Band operator()(const FanJob &job)
+    {
+        PercentileFan::Band part;
+        const int n=job.end-job.begin;
+        part.time.resize(n);
+        for(int l=0;l<PercentileFan::LevelCount;l++)
+            part.levels[l].resize(n);
+        QVector<float> values;
+        values.reserve(job.sources->size());
+        for(int i=0;i<n && !job.token->isCancelled();i++)
+        {
+            const double t=job.tBegin+(job.begin+i)*job.step;
+            part.time[i]=t;
+            values.clear();
+            for(int r=0;r<job.sources->size();r++)
+            {
+                const FanSource &source=(*job.sources)[r];
+                float v=PercentileFan::valueAt(source.time,source.values,t);
+                if(qIsFinite(v))
+                    values.append(v);
+            }
+            std::sort(values.begin(),values.end());
+            for(int l=0;l<PercentileFan::LevelCount;l++)
+                part.levels[l][i]=quantile(values,KPercents[l]);
+        }
+        return part;
+    }
+};
+
+struct FanTask
+{
+    typedef PercentileFan::Bands result_type;
+    QList<int> channels;
+    QList<QVector<FanSource> > sources;//по каналам
+    double tBegin;
+    double step;
+    int gridPoints;
+
+    result_type operator()(const TaskScheduler::Token &token) const
+    {
+        result_type bands;
+        for(int c=0;c<channels.size() && !token.isCancelled();c++)
+        {
+            QList<FanJob> jobs;
+            for(int begin=0;begin<gridPoints;begin+=KChunkPoints)
+            {
+                FanJob job;
+                job.sources=&sources[c];
+                job.token=&token;
+                job.tBegin=tBegin;
+                job.step=step;
+                job.begin=begin;
+                job.end=qMin(gridPoints,begin+KChunkPoints);
+                jobs<<job;
+            }
+            //участки сетки считаются параллельно
+            QList<PercentileFan::Band> parts=QtConcurrent::blockingMapped(jobs,FanFunctor());
+            PercentileFan::Band &band=bands[channels[c]];
+            for(int i=0;i<parts.size();i++)
+            {
+                band.time+=parts[i].time;
+                for(int l=0;l<PercentileFan::LevelCount;l++)
+                    band.levels[l]+=parts[i].levels[l];
+            }
+        }
+        return bands;
+    }
+};
+}
+
+PercentileFan::PercentileFan(GraphData &data, QObject *parent)
+    : QObject(parent)
+    , m_data(data)
+{
+    connect(&m_watcher,SIGNAL(finished()),SLOT(computed()));
+}
+
+void PercentileFan::compute(const QList<int> &channels, int gridPoints)
+{
+    //та же сводка уже посчитана или считается - перерисовка её не перезапускает
+    QString signature=QString::number(gridPoints);
+    for(int c=0;c<channels.size();c++)
+        signature+=","+QString::number(channels[c]);
+    for(int i=0;i<m_data.length();i++)
+        signature+=";"+m_data.get_name(i)+":"+QString::number(m_data.time(i).size());
+    if(signature==m_signature)
+        return;
+    m_signature=signature;
+    m_watcher.cancel();
+    double tBegin=qInf();
+    double tEnd=-qInf();
+    for(int i=0;i<m_data.length();i++)
+    {
+        const QVector<double> &time=m_data.time(i);
+        if(time.isEmpty())
+            continue;
+        tBegin=qMin(tBegin,time.first());
+        tEnd=qMax(tEnd,time.last());
+    }
+    if(tBegin>tEnd || gridPoints<1)
+    {
+        m_bands.clear();
+        return;
+    }
+    FanTask task;
+    task.channels=channels;
+    task.tBegin=tBegin;
+    task.step=gridPoints>1 ? (tEnd-tBegin)/(gridPoints-1) : 0;
+    task.gridPoints=gridPoints;
+    for(int c=0;c<channels.size();c++)
+    {
+        //столбцы берутся здесь: производные каналы вычисляются только в потоке интерфейса
+        QVector<FanSource> sources;
+        for(int i=0;i<m_data.length();i++)
+        {
+            FanSource source;
+            source.time=m_data.time(i);
+            source.values=m_data.column(i,channels[c]);
+            sources<<source;
+        }
+        task.sources<<sources;
+    }
+    m_watcher.setFuture(TaskScheduler::run(TaskScheduler::VisibleRuns,task));
+}
+
+void PercentileFan::computed()
+{
+    if(m_watcher.isCanceled())
+        return;
+    m_bands=m_watcher.result();
+    emit changed();
+}
+
+const PercentileFan::Band &PercentileFan::band(int channel)
+{
+    return m_bands[channel];
+}
+
+float PercentileFan::percent(int level)
+{
+    return KPercents[level];
+}
+
+//Линейная интерполяция между ближайшими отсчётами; вне диапазона прогона - NaN
+float PercentileFan::valueAt(const QVector<double> &time, const QVector<float> &values, double t)
+{
+    const int n=qMin(time.size(),values.size());
+    if(n==0 || t<time[0] || t>time[n-1])
+        return float(qQNaN());
+    const int after=std::lower_bound(time.constBegin(),time.constBegin()+n,t)-time.constBegin();
+    if(after==0 || time[after]==t)
+        return values[after];
+    const int before=after-1;
+    const double a=(t-time[before])/(time[after]-time[before]);
+    return float(values[before]+a*(values[after]-values[before]));
+}
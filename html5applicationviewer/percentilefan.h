@@ -0,0 +1,50 @@
+#ifndef PERCENTILEFAN_H
+#define PERCENTILEFAN_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QFutureWatcher>
+
+#include "graphdata.h"
+
+//Сводка по большому числу прогонов: каналы всех прогонов пересчитываются на общую сетку времени,
+//в каждом узле сетки берутся процентили по прогонам. Значение прогона в узле ищется двоичным
+//поиском, поэтому стоимость зависит от числа узлов и прогонов, а не от длины прогонов.
+//Считается в фоне; пока идёт расчёт, band() отдаёт прежнюю сводку, о новой сообщает changed()
+class PercentileFan : public QObject
+{
+    Q_OBJECT
+public:
+    enum Level{P5,P25,P50,P75,P95,LevelCount};
+
+    struct Band
+    {
+        QVector<double> time;//узлы сетки
+        QVector<float> levels[LevelCount];//NaN - в узле нет ни одного прогона
+    };
+
+    typedef QHash<int,Band> Bands;
+
+    explicit PercentileFan(GraphData &data,QObject *parent = 0);
+
+    void compute(const QList<int> &channels,int gridPoints);//все прогоны, сетка на общем диапазоне времени
+    const Band &band(int channel);
+    static float percent(int level);
+    static float valueAt(const QVector<double> &time,const QVector<float> &values,double t);
+
+signals:
+    void changed();
+
+private slots:
+    void computed();
+
+private:
+    GraphData &m_data;
+    Bands m_bands;
+    QFutureWatcher<Bands> m_watcher;
+    QString m_signature;//каналы, сетка и размеры прогонов посчитанной или считаемой сводки
+};
+
+#endif // PERCENTILEFAN_H
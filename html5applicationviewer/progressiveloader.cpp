@@ -0,0 +1,236 @@
+#include "progressiveloader.h"
+#include <qnumeric.h>
+
+static const int KRefineFactor = 4;//во сколько раз плотнее каждая следующая выборка
+static const int KAllColumns = (1<<LogRangeReader::ColumnCount)-1;
+static const int KIndexChunk = 65536;//записей между проверками отмены
+static const int KReadChunk = 4096;
+
+namespace
+{
+struct PassTask
+{
+    typedef ProgressiveLoader::Pass result_type;
+    QString fileName;
+    int stride;
+    int overviewPoints;
+    result_type operator()(const TaskScheduler::Token &token) const
+    {
+        return ProgressiveLoader::read(fileName,stride,overviewPoints,token);
+    }
+};
+
+struct WindowTask
+{
+    typedef LogRangeReader::Window result_type;
+    QSharedPointer<LogRangeReader> reader;//держит файл открытым, даже если прогон уже удалён
+    int columns;
+    double tBegin;
+    double tEnd;
+    int maxPoints;
+    result_type operator()(const TaskScheduler::Token &) const
+    {
+        return reader->read(columns,tBegin,tEnd,maxPoints);
+    }
+};
+}
+
+ProgressiveLoader::ProgressiveLoader(GraphData &data, int samplePoints, int overviewPoints, QObject *parent)
+    : QObject(parent)
+    , m_data(data)
+    , m_samplePoints(samplePoints)
+    , m_overviewPoints(overviewPoints)
+{
+
+}
+
+void ProgressiveLoader::start(const QString &run, const QString &fileName, bool progressive)
+{
+    cancel(run);
+    Job job;
+    job.fileName=fileName;
+    job.records=0;
+    job.stride=0;
+    job.watcher=0;
+    if(progressive && m_data.attach(run,fileName,m_samplePoints))
+    {
+        job.records=m_data.recordCount(m_data.findByName(run));
+        job.stride=qMax(1,(job.records+m_samplePoints-1)/qMax(1,m_samplePoints));
+    }
+    else if(m_data.findByName(run)!=-1)
+        return;
+    schedule(job);
+    m_jobs.insert(run,job);
+}
+
+void ProgressiveLoader::schedule(Job &job)
+{
+    //выборка плотнее обзора не нужна: дальше сразу точный проход
+    if(job.stride>0)
+    {
+        job.stride/=KRefineFactor;
+        if(job.stride<=1 || job.records/job.stride>=m_overviewPoints)
+            job.stride=1;
+    }
+    PassTask task;
+    task.fileName=job.fileName;
+    task.stride=job.stride;
+    task.overviewPoints=m_overviewPoints;
+    job.watcher=new Watcher(this);
+    connect(job.watcher,SIGNAL(finished()),SLOT(passFinished()));
+    job.watcher->setFuture(TaskScheduler::run(TaskScheduler::VisibleRuns,task));
+}
+
+ProgressiveLoader::Pass ProgressiveLoader::read(const QString &fileName, int stride, int overviewPoints, const TaskScheduler::Token &token)
+{
+    Pass pass;
+    pass.stride=stride;
+    pass.damaged=false;
+    if(stride==0)
+    {
+        //повреждённые участки пропускаются, прочитанное показывается вместе с отчётом
+        Logger l;
+        DataSet dataset;
+        l.setFileName(fileName);
+        l.setRecovery(true);
+        l.beginRead();
+        while(l.canRead())
+        {
+            l>>dataset;
+            pass.records.append(dataset);
+            if(pass.records.size()%KReadChunk==0 && token.isCancelled())
+                break;
+        }
+        pass.damage=l.damage();
+        l.endRead();
+        return pass;
+    }
+    //у прохода свой отображённый файл: общий читатель прогона меняется только в потоке интерфейса
+    LogRangeReader reader;
+    if(!reader.open(fileName))
+    {
+        pass.damaged=true;
+        return pass;
+    }
+    if(stride>1)
+    {
+        pass.window=reader.sample(KAllColumns,stride);
+        return pass;
+    }
+    while(pass.index.size()<reader.recordCount())
+    {
+        if(token.isCancelled())
+            return pass;
+        if(!reader.extendIndex(pass.index,KIndexChunk))
+        {
+            pass.damaged=true;
+            return pass;
+        }
+    }
+    reader.setIndex(pass.index);
+    pass.window=reader.read(KAllColumns,-qInf(),qInf(),overviewPoints);
+    return pass;
+}
+
+void ProgressiveLoader::passFinished()
+{
+    Watcher *watcher=static_cast<Watcher*>(sender());
+    watcher->deleteLater();
+    QString run;
+    for(QHash<QString,Job>::iterator it=m_jobs.begin();it!=m_jobs.end();++it)
+        if(it.value().watcher==watcher)
+            run=it.key();
+    if(run.isEmpty() || watcher->isCanceled())
+        return;
+    const Pass pass=watcher->result();
+    Job &job=m_jobs[run];
+    if(pass.stride==0)
+    {
+        m_jobs.remove(run);
+        if(!m_data.createNew(run))
+            return;
+        for(int i=0;i<pass.records.size();i++)
+            m_data.addTo(run,pass.records[i]);
+        emit loaded(run,pass.damage);
+        return;
+    }
+    int index=m_data.findByName(run);
+    if(index==-1)
+    {
+        m_jobs.remove(run);
+        return;
+    }
+    if(pass.damaged)
+    {
+        QString fileName=job.fileName;
+        m_jobs.remove(run);
+        emit damaged(run,fileName);
+        return;
+    }
+    m_data.refine(index,pass.window,pass.index);
+    const bool final=pass.stride==1;
+    if(final)
+        m_jobs.remove(run);
+    else
+        schedule(job);
+    emit refined(run,final);
+}
+
+void ProgressiveLoader::loadWindow(const QString &run, const QList<int> &channels, double tBegin, double tEnd, int maxPoints)
+{
+    int index=m_data.findByName(run);
+    if(index==-1)
+        return;
+    //окно для прежнего положения графика уже не нужно
+    if(m_windows.contains(run))
+        discard(m_windows.take(run).watcher);
+    WindowTask task;
+    task.reader=m_data.source(index);
+    task.columns=GraphData::columnMask(channels);
+    task.tBegin=tBegin;
+    task.tEnd=tEnd;
+    task.maxPoints=maxPoints;
+    WindowJob job;
+    job.columns=task.columns;
+    job.tBegin=tBegin;
+    job.tEnd=tEnd;
+    job.watcher=new WindowWatcher(this);
+    connect(job.watcher,SIGNAL(finished()),SLOT(windowFinished()));
+    job.watcher->setFuture(TaskScheduler::run(TaskScheduler::VisibleRange,task));
+    m_windows.insert(run,job);
+}
+
+void ProgressiveLoader::windowFinished()
+{
+    WindowWatcher *watcher=static_cast<WindowWatcher*>(sender());
+    watcher->deleteLater();
+    QString run;
+    for(QHash<QString,WindowJob>::iterator it=m_windows.begin();it!=m_windows.end();++it)
+        if(it.value().watcher==watcher)
+            run=it.key();
+    if(run.isEmpty() || watcher->isCanceled())
+        return;
+    const WindowJob job=m_windows.take(run);
+    int index=m_data.findByName(run);
+    if(index==-1)
+        return;
+    m_data.load(index,watcher->result(),job.columns,job.tBegin,job.tEnd);
+    emit windowLoaded(run);
+}
+
+void ProgressiveLoader::cancel(const QString &run)
+{
+    if(m_jobs.contains(run))
+        discard(m_jobs.take(run).watcher);
+    if(m_windows.contains(run))
+        discard(m_windows.take(run).watcher);
+}
+
+template<typename T>
+void ProgressiveLoader::discard(QFutureWatcher<T> *watcher)
+{
+    //ещё не начатая задача не запустится, результат идущей просто не будет принят
+    watcher->cancel();
+    disconnect(watcher,0,this,0);
+    connect(watcher,SIGNAL(finished()),watcher,SLOT(deleteLater()));
+}
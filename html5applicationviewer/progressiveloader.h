@@ -0,0 +1,80 @@
+#ifndef PROGRESSIVELOADER_H
+#define PROGRESSIVELOADER_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QFutureWatcher>
+
+#include "graphdata.h"
+#include "logger.h"
+#include "taskscheduler.h"
+
+//Загрузка прогонов в фоне через TaskScheduler. Небольшой файл читается целиком через Logger
+//с восстановлением. Большой сразу показывается редкой выборкой записей, затем всё более
+//плотными выборками, а последний проход строит точный индекс времени и обзор min/max.
+//Каждый проход заменяет данные прогона в GraphData, после чего испускается refined.
+//Подробное окно видимого диапазона читается задачей с наивысшим приоритетом
+class ProgressiveLoader : public QObject
+{
+    Q_OBJECT
+public:
+    struct Pass
+    {
+        LogRangeReader::Window window;//выборка или обзор
+        QVector<double> index;//точное время записей, только у точного прохода
+        QVector<DataSet> records;//полное чтение
+        Logger::DamageReport damage;
+        int stride;//1 - точный проход, 0 - полное чтение
+        bool damaged;//файл не читается напрямую, нужен Logger с восстановлением
+    };
+
+    ProgressiveLoader(GraphData &data,int samplePoints,int overviewPoints,QObject *parent = 0);
+
+    //progressive=false - файл читается целиком
+    void start(const QString &run,const QString &fileName,bool progressive);
+    void loadWindow(const QString &run,const QList<int> &channels,double tBegin,double tEnd,int maxPoints);
+    void cancel(const QString &run);
+    bool isLoading(const QString &run) const {return m_jobs.contains(run);}
+
+    static Pass read(const QString &fileName,int stride,int overviewPoints,const TaskScheduler::Token &token);
+
+signals:
+    void loaded(const QString &run,const Logger::DamageReport &damage);
+    void refined(const QString &run,bool final);
+    void windowLoaded(const QString &run);
+    void damaged(const QString &run,const QString &fileName);
+
+private slots:
+    void passFinished();
+    void windowFinished();
+
+private:
+    typedef QFutureWatcher<Pass> Watcher;
+    typedef QFutureWatcher<LogRangeReader::Window> WindowWatcher;
+    struct Job
+    {
+        QString fileName;
+        int records;
+        int stride;
+        Watcher *watcher;
+    };
+    struct WindowJob
+    {
+        int columns;
+        double tBegin;
+        double tEnd;
+        WindowWatcher *watcher;
+    };
+    GraphData &m_data;
+    int m_samplePoints;
+    int m_overviewPoints;
+    QHash<QString,Job> m_jobs;
+    QHash<QString,WindowJob> m_windows;
+    void schedule(Job &job);//следующий проход
+    template<typename T> void discard(QFutureWatcher<T> *watcher);
+};
+
+#endif // PROGRESSIVELOADER_H
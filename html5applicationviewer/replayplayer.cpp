@@ -0,0 +1,236 @@
+#include "replayplayer.h"
+#include "framescheduler.h"
+#include "common.h"
+#include <qnumeric.h>
+#include <algorithm>
+#include <cstring>
+
+static const int KChunkRecords = 16384;
+static const int KSeekBlock = 65536;//записей между проверками отмены при перемотке
+static const double KAheadSeconds = 2;//запас прочитанного впереди, в секундах реального времени
+
+namespace
+{
+struct ChunkTask
+{
+    typedef ReplayPlayer::Chunk result_type;
+    QSharedPointer<LogRangeReader> reader;
+    int record;
+    double time;
+    double seekTime;
+    result_type operator()(const TaskScheduler::Token &token) const
+    {
+        return ReplayPlayer::read(reader,record,time,seekTime,KChunkRecords,token);
+    }
+};
+}
+
+ReplayPlayer::ReplayPlayer(QObject *parent)
+    : QObject(parent)
+    , m_position(0)
+    , m_time(0)
+    , m_speed(1)
+    , m_atEnd(true)
+    , m_damaged(false)
+    , m_watcher(0)
+{
+    m_timer.setInterval(FrameScheduler::KFrameIntervalMs);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer,SIGNAL(timeout()),SLOT(tick()));
+}
+
+bool ReplayPlayer::open(const QString &fileName)
+{
+    pause();
+    //идущее чтение держит свою копию указателя, прежний файл закроется после него
+    m_reader=QSharedPointer<LogRangeReader>(new LogRangeReader);
+    if(!m_reader->open(fileName))
+        m_reader.clear();
+    seek(0);
+    return !m_reader.isNull();
+}
+
+void ReplayPlayer::seek(double t)
+{
+    discard();
+    m_chunks.clear();
+    m_position=0;
+    m_time=t;
+    m_atEnd=m_reader.isNull();
+    m_damaged=false;
+    if(!m_atEnd)
+        prefetch(t);
+}
+
+void ReplayPlayer::play()
+{
+    if(m_reader.isNull())
+        return;
+    if(m_atEnd && !isBuffering() && record()==m_reader->recordCount()-1)
+        seek(0);
+    m_clock.start();
+    m_timer.start();
+}
+
+void ReplayPlayer::pause()
+{
+    m_timer.stop();
+}
+
+bool ReplayPlayer::isBuffering() const
+{
+    if(!m_watcher)
+        return false;
+    if(m_chunks.isEmpty())
+        return true;
+    const Chunk &current=m_chunks.first();
+    return m_chunks.size()==1 && m_position==current.time.size()-1 && m_time>=current.nextTime;
+}
+
+int ReplayPlayer::record() const
+{
+    return m_chunks.isEmpty() ? -1 : m_chunks.first().firstRecord+m_position;
+}
+
+const uchar *ReplayPlayer::frame() const
+{
+    return m_chunks.isEmpty() ? 0 : (const uchar*)m_chunks.first().frames.constData()+m_position*CAMERA_FRAME_LEN;
+}
+
+float ReplayPlayer::linePosition() const
+{
+    return m_chunks.isEmpty() ? qQNaN() : m_chunks.first().linePosition[m_position];
+}
+
+void ReplayPlayer::tick()
+{
+    const double elapsed=m_clock.nsecsElapsed()*1e-9;
+    m_clock.restart();
+    if(m_chunks.isEmpty())
+    {
+        if(m_atEnd)
+        {
+            pause();
+            emit ended();
+        }
+        return;
+    }
+    double target=m_time+elapsed*m_speed;
+    //текущая запись - последняя с временем не позже target
+    while(true)
+    {
+        const Chunk &chunk=m_chunks.first();
+        const int k=int(std::upper_bound(chunk.time.constBegin()+m_position,chunk.time.constEnd(),target)-chunk.time.constBegin())-1;
+        m_position=qMax(m_position,k);
+        if(m_position<chunk.time.size()-1 || m_chunks.size()<2 || m_chunks[1].time.first()>target)
+            break;
+        m_chunks.removeFirst();
+        m_position=0;
+    }
+    const Chunk &current=m_chunks.first();
+    if(m_chunks.size()==1 && m_position==current.time.size()-1 && target>=current.nextTime)
+    {
+        if(m_atEnd)
+        {
+            m_time=current.nextTime;
+            pause();
+            emit advanced(m_time);
+            emit ended();
+            return;
+        }
+        //чтение не успело: время не уходит дальше прочитанного
+        target=current.nextTime;
+    }
+    m_time=target;
+    emit advanced(m_time);
+    if(!m_atEnd && !m_watcher && (m_chunks.last().nextTime-m_time)/m_speed<KAheadSeconds)
+        prefetch(-qInf());
+}
+
+void ReplayPlayer::prefetch(double seekTime)
+{
+    ChunkTask task;
+    task.reader=m_reader;
+    task.record=m_chunks.isEmpty() ? 0 : m_chunks.last().nextRecord;
+    task.time=m_chunks.isEmpty() ? 0 : m_chunks.last().nextTime;
+    task.seekTime=seekTime;
+    m_watcher=new Watcher(this);
+    connect(m_watcher,SIGNAL(finished()),SLOT(chunkLoaded()));
+    //воспроизводимое видно на экране, поэтому чтение идёт впереди прочей фоновой работы
+    m_watcher->setFuture(TaskScheduler::run(TaskScheduler::VisibleRange,task));
+}
+
+void ReplayPlayer::chunkLoaded()
+{
+    Watcher *watcher=m_watcher;
+    m_watcher=0;
+    watcher->deleteLater();
+    if(watcher->isCanceled())
+        return;
+    const Chunk chunk=watcher->result();
+    if(chunk.damaged || chunk.nextRecord>=m_reader->recordCount())
+        m_atEnd=true;
+    m_damaged=chunk.damaged;
+    if(chunk.time.isEmpty())
+        return;
+    m_chunks<<chunk;
+    if(m_chunks.size()==1)
+        emit advanced(m_time);
+}
+
+void ReplayPlayer::discard()
+{
+    if(!m_watcher)
+        return;
+    m_watcher->cancel();
+    disconnect(m_watcher,0,this,0);
+    connect(m_watcher,SIGNAL(finished()),m_watcher,SLOT(deleteLater()));
+    m_watcher=0;
+}
+
+ReplayPlayer::Chunk ReplayPlayer::read(const QSharedPointer<LogRangeReader> &reader, int record, double time, double seekTime, int count, const TaskScheduler::Token &token)
+{
+    Chunk chunk;
+    const int total=reader->recordCount();
+    //смещения полей фиксированы: повреждённые записи не читаются, воспроизведение на них кончается
+    //перемотка: шаги добавляются, пока следующая запись не позже seekTime;
+    //продолжение (seekTime=-inf) начинается сразу с record
+    while(seekTime>=time && record<total-1 && !token.isCancelled())
+    {
+        const int blockEnd=qMin(total,record+KSeekBlock);
+        const int valid=reader->firstDamaged(record,blockEnd);
+        const int last=valid<blockEnd ? valid-1 : total-1;//на последней годной записи перемотка стоит
+        LogRangeReader::Window steps=reader->readRecords(1<<LogRangeReader::PhysicsTimestep,record,valid);
+        const QVector<float> &dt=steps.columns[LogRangeReader::PhysicsTimestep];
+        int i=0;
+        for(;i<dt.size() && record+i<last;i++)
+        {
+            const double next=time+(qIsFinite(dt[i]) && dt[i]>0 ? dt[i] : 0);
+            if(next>seekTime)
+                break;
+            time=next;
+        }
+        record+=i;
+        if(i<dt.size() || valid<blockEnd)
+            break;
+    }
+    const int end=reader->firstDamaged(record,qMin(total,record+count));
+    chunk.damaged=end<qMin(total,record+count);
+    const int size=qMax(0,end-record);
+    LogRangeReader::Window window=reader->readRecords(1<<LogRangeReader::PhysicsTimestep|1<<LogRangeReader::LinePosition,record,end);
+    chunk.firstRecord=record;
+    chunk.time.resize(size);
+    chunk.linePosition=window.columns[LogRangeReader::LinePosition];
+    chunk.frames.resize(size*CAMERA_FRAME_LEN);
+    for(int i=0;i<size;i++)
+    {
+        chunk.time[i]=time;
+        const float dt=window.columns[LogRangeReader::PhysicsTimestep][i];
+        if(qIsFinite(dt) && dt>0)
+            time+=dt;
+        memcpy(chunk.frames.data()+i*CAMERA_FRAME_LEN,reader->cameraFrame(record+i),CAMERA_FRAME_LEN);
+    }
+    chunk.nextRecord=qMax(record,end);
+    chunk.nextTime=time;
+    return chunk;
+}
@@ -0,0 +1,77 @@
+#ifndef REPLAYPLAYER_H
+#define REPLAYPLAYER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include <QFutureWatcher>
+
+#include "lograngereader.h"
+#include "taskscheduler.h"
+
+//Воспроизведение прогона: время идёт по накопленному physics_timestep, ускоренное в speed раз.
+//Часы тикают раз в кадр и берут прошедшее реальное время, поэтому пропущенный кадр
+//не замедляет воспроизведение. Записи читаются из лога кусками в фоне с опережением,
+//и на большом файле чтение не задерживает кадры; если данные всё же не успели, время стоит
+class ReplayPlayer : public QObject
+{
+    Q_OBJECT
+public:
+    struct Chunk
+    {
+        int firstRecord;
+        QVector<double> time;
+        QVector<float> linePosition;//NaN - линия не найдена
+        QByteArray frames;//CAMERA_FRAME_LEN байт на запись
+        int nextRecord;//с чего продолжить следующим куском
+        double nextTime;
+        bool damaged;//на nextRecord повреждённая запись, дальше чтения нет
+    };
+
+    explicit ReplayPlayer(QObject *parent = 0);
+
+    bool open(const QString &fileName);
+    void seek(double t);
+    void play();
+    void pause();
+    bool isPlaying() const {return m_timer.isActive();}
+    bool isBuffering() const;//время стоит в ожидании чтения
+    void setSpeed(double speed) {m_speed=speed;}
+    double time() const {return m_time;}
+    int record() const;//-1 - нет данных
+    const uchar *frame() const;
+    float linePosition() const;
+    bool isDamaged() const {return m_damaged;}//воспроизведение кончается на повреждённой записи
+
+    //перемотка до seekTime читает только шаги времени
+    static Chunk read(const QSharedPointer<LogRangeReader> &reader,int record,double time,double seekTime,int count,const TaskScheduler::Token &token);
+
+signals:
+    void advanced(double t);
+    void ended();
+
+private slots:
+    void tick();
+    void chunkLoaded();
+
+private:
+    typedef QFutureWatcher<Chunk> Watcher;
+    QSharedPointer<LogRangeReader> m_reader;
+    QList<Chunk> m_chunks;//прочитанные впереди записи, текущая - в первом куске
+    int m_position;
+    double m_time;
+    double m_speed;
+    bool m_atEnd;//последний кусок уже прочитан
+    bool m_damaged;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    Watcher *m_watcher;
+    void prefetch(double seekTime);
+    void discard();
+};
+
+#endif // REPLAYPLAYER_H
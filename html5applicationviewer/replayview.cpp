@@ -0,0 +1,153 @@
+#include "replayview.h"
+#include <QGridLayout>
+#include <QPainter>
+#include <qnumeric.h>
+#include <cstring>
+
+static const int KHistoryRows = 240;
+static const int KFrameHeight = 48;
+
+ReplayView::ReplayView(QWidget *parent)
+    : QWidget(parent,Qt::Window)
+    , m_startTime(0)
+{
+    setWindowTitle(tr("Replay"));
+    m_run=new QComboBox;
+    m_speed=new QComboBox;
+    m_speed->addItem("1x",1);
+    m_speed->addItem("10x",10);
+    m_speed->addItem("100x",100);
+    m_play=new QPushButton(tr("Play"));
+    m_status=new QLabel;
+    QGridLayout *layout=new QGridLayout;
+    layout->addWidget(m_run,0,0);
+    layout->addWidget(m_speed,0,1);
+    layout->addWidget(m_play,0,2);
+    layout->addWidget(m_status,1,0,1,3);
+    layout->setRowStretch(2,1);
+    setLayout(layout);
+    connect(m_run,SIGNAL(activated(int)),SLOT(runChanged()));
+    connect(m_speed,SIGNAL(activated(int)),SLOT(speedChanged()));
+    connect(m_play,SIGNAL(clicked()),SLOT(playPause()));
+    connect(&m_player,SIGNAL(advanced(double)),SLOT(advanced(double)));
+    connect(&m_player,SIGNAL(ended()),SLOT(ended()));
+    m_history=QImage(CAMERA_FRAME_LEN,KHistoryRows,QImage::Format_RGB32);
+    m_history.fill(Qt::black);
+    resize(520,420);
+}
+
+void ReplayView::refreshLists(const QStringList &runs, const QStringList &fileNames)
+{
+    QString run=m_run->currentText();
+    m_run->clear();
+    m_run->addItems(runs);
+    m_fileNames=fileNames;
+    m_run->setCurrentIndex(qMax(0,m_run->findText(run)));
+    if(m_run->currentText()!=m_openedRun)
+        runChanged();
+}
+
+void ReplayView::setStartTime(double t)
+{
+    m_startTime=qIsFinite(t) ? t : 0;
+    if(!m_player.isPlaying())
+        m_player.seek(m_startTime);
+}
+
+void ReplayView::runChanged()
+{
+    m_history.fill(Qt::black);
+    m_openedRun=m_run->currentText();
+    m_play->setText(tr("Play"));
+    int index=m_run->currentIndex();
+    if(index<0 || !m_player.open(m_fileNames.value(index)))
+    {
+        m_status->setText(tr("No run loaded"));
+        update();
+        return;
+    }
+    m_player.setSpeed(m_speed->itemData(m_speed->currentIndex()).toDouble());
+    m_player.seek(m_startTime);
+}
+
+void ReplayView::speedChanged()
+{
+    m_player.setSpeed(m_speed->itemData(m_speed->currentIndex()).toDouble());
+}
+
+void ReplayView::playPause()
+{
+    if(m_player.isPlaying())
+    {
+        m_player.pause();
+        m_play->setText(tr("Play"));
+        return;
+    }
+    m_player.play();
+    if(m_player.isPlaying())
+        m_play->setText(tr("Pause"));
+}
+
+void ReplayView::ended()
+{
+    m_play->setText(tr("Play"));
+    if(m_player.isDamaged())
+        m_status->setText(m_status->text()+tr(", the rest of the log is damaged"));
+}
+
+void ReplayView::advanced(double t)
+{
+    const uchar *frame=m_player.frame();
+    if(frame)
+    {
+        //лента сдвигается на строку за кадр воспроизведения
+        const int stride=m_history.bytesPerLine();
+        memmove(m_history.bits(),m_history.bits()+stride,stride*(KHistoryRows-1));
+        QRgb *line=(QRgb*)m_history.scanLine(KHistoryRows-1);
+        for(int i=0;i<CAMERA_FRAME_LEN;i++)
+            line[i]=qRgb(frame[i],frame[i],frame[i]);
+        const float position=m_player.linePosition();
+        if(qIsFinite(position) && position>=0 && position<CAMERA_FRAME_LEN)
+            line[int(position)]=qRgb(255,0,0);
+    }
+    QString text=tr("t = %1 s, record %2").arg(t,0,'f',3).arg(m_player.record());
+    if(m_player.isBuffering())
+        text+=tr(", reading...");
+    m_status->setText(text);
+    update();
+    emit timeChanged(t);
+}
+
+QRect ReplayView::frameRect() const
+{
+    QRect area=rect().adjusted(10,m_status->geometry().bottom()+10,-10,-10);
+    return QRect(area.left(),area.top(),area.width(),KFrameHeight);
+}
+
+QRect ReplayView::historyRect() const
+{
+    QRect frame=frameRect();
+    return QRect(frame.left(),frame.bottom()+6,frame.width(),qMax(0,height()-10-frame.bottom()-6));
+}
+
+void ReplayView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    const uchar *frame=m_player.frame();
+    if(!frame)
+        return;
+    QRect area=frameRect();
+    QImage current(CAMERA_FRAME_LEN,1,QImage::Format_RGB32);
+    QRgb *line=(QRgb*)current.scanLine(0);
+    for(int i=0;i<CAMERA_FRAME_LEN;i++)
+        line[i]=qRgb(frame[i],frame[i],frame[i]);
+    painter.drawImage(area,current);
+    const float position=m_player.linePosition();
+    if(qIsFinite(position))
+    {
+        double x=area.left()+(position+0.5)*area.width()/CAMERA_FRAME_LEN;
+        painter.setPen(QPen(Qt::red,2));
+        painter.drawLine(QPointF(x,area.top()),QPointF(x,area.bottom()));
+    }
+    painter.drawImage(historyRect(),m_history);
+}
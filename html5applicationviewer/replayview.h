@@ -0,0 +1,45 @@
+#ifndef REPLAYVIEW_H
+#define REPLAYVIEW_H
+
+#include <QWidget>
+#include <QComboBox>
+#include <QPushButton>
+#include <QLabel>
+#include <QImage>
+
+#include "replayplayer.h"
+
+//Воспроизведение прогона: текущий кадр камеры с отметкой line_position и лента
+//предыдущих кадров. Время воспроизведения сообщается, чтобы курсор шёл по всем графикам
+class ReplayView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit ReplayView(QWidget *parent = 0);
+    void refreshLists(const QStringList &runs,const QStringList &fileNames);
+    void setStartTime(double t);//с какого времени начнётся воспроизведение прогона
+signals:
+    void timeChanged(double t);
+private slots:
+    void runChanged();
+    void playPause();
+    void speedChanged();
+    void advanced(double t);
+    void ended();
+protected:
+    void paintEvent(QPaintEvent *event);
+private:
+    ReplayPlayer m_player;
+    QComboBox *m_run;
+    QComboBox *m_speed;
+    QPushButton *m_play;
+    QLabel *m_status;
+    QStringList m_fileNames;
+    QString m_openedRun;
+    double m_startTime;
+    QImage m_history;//строка на кадр, новые снизу
+    QRect frameRect() const;
+    QRect historyRect() const;
+};
+
+#endif // REPLAYVIEW_H
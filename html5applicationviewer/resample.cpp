@@ -0,0 +1,28 @@
+#include "resample.h"
+#include <qnumeric.h>
+
+QVector<float> resample(const QVector<double> &srcTime, const QVector<float> &src, const QVector<double> &dstTime)
+{
+    const int n=dstTime.size();
+    const int m=srcTime.size();
+    QVector<float> result(n,float(qQNaN()));
+    if(m==0)
+        return result;
+    int j=0;
+    for(int i=0;i<n;i++)
+    {
+        const double t=dstTime[i];
+        if(t<srcTime[0] || t>srcTime[m-1])
+            continue;
+        while(j+1<m && srcTime[j+1]<t)
+            j++;
+        if(j+1>=m || srcTime[j+1]==srcTime[j])
+        {
+            result[i]=src[j];
+            continue;
+        }
+        const double a=(t-srcTime[j])/(srcTime[j+1]-srcTime[j]);
+        result[i]=float(src[j]+a*(src[j+1]-src[j]));
+    }
+    return result;
+}
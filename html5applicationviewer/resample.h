@@ -0,0 +1,10 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include <QVector>
+
+//Линейная интерполяция src на моменты dstTime; вне диапазона src - NaN.
+//srcTime и dstTime возрастают, поэтому проход один
+QVector<float> resample(const QVector<double> &srcTime,const QVector<float> &src,const QVector<double> &dstTime);
+
+#endif // RESAMPLE_H
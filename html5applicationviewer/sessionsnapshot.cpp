@@ -0,0 +1,229 @@
+#include "sessionsnapshot.h"
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <cstring>
+
+static const quint32 KSnapshotMagic = 0x47565353;//"GVSS"
+static const quint32 KSnapshotVersion = 1;
+static const quint32 KByteOrderMark = 0x01020304;//массивы пишутся в порядке байт машины
+static const int KHeaderSize = 24;//magic, version, порядок байт, резерв, смещение оглавления
+static const int KAlignment = 8;
+static const quint32 KMaxBlocks = 64;
+
+namespace
+{
+//массив выравнивается, чтобы в отображённом файле double и float лежали по своим границам
+SessionSnapshot::Block writeArray(QFileDevice &file,const void *data,int count,int elementSize)
+{
+    static const char zeros[KAlignment]={0};
+    file.write(zeros,(KAlignment-file.pos()%KAlignment)%KAlignment);
+    SessionSnapshot::Block block;
+    block.offset=file.pos();
+    block.count=count;
+    block.elementSize=elementSize;
+    file.write((const char*)data,qint64(count)*elementSize);
+    return block;
+}
+
+template<typename T>
+SessionSnapshot::Block writeArray(QFileDevice &file,const QVector<T> &values)
+{
+    return writeArray(file,values.constData(),values.size(),sizeof(T));
+}
+}
+
+SessionSnapshot::SessionSnapshot()
+    : m_data(0)
+    , m_arraysEnd(0)
+{
+
+}
+
+SessionSnapshot::~SessionSnapshot()
+{
+    close();
+}
+
+bool SessionSnapshot::save(const QString &fileName, GraphData &data, const QList<Run> &runs, const Layout &layout)
+{
+    //QSaveFile подменяет прежний снимок только при commit(), оборванная запись его не портит
+    QSaveFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+    //заголовок пишется последним, когда известно смещение оглавления
+    file.write(QByteArray(KHeaderSize,0));
+    QList<Run> written=runs;
+    QList<QVector<Block> > blocks;
+    for(int i=0;i<written.size();i++)
+    {
+        Run &run=written[i];
+        QFileInfo info(run.path);
+        run.size=info.size();
+        run.modified=info.lastModified().toMSecsSinceEpoch();
+        run.kind=PathOnly;
+        QVector<Block> list;
+        int index=data.findByName(run.name);
+        if(index==-1)
+        {
+            //ещё читается - в снимке остаётся только путь
+        }
+        else if(!data.isPartial(index))
+        {
+            run.kind=Full;
+            list<<writeArray(file,data.time(index));
+            for(int c=0;c<GraphData::ChannelCount;c++)
+                list<<writeArray(file,data.column(index,c));
+            list<<writeArray(file,data.positionX(index));
+            list<<writeArray(file,data.positionZ(index));
+        }
+        else if(data.isIndexed(index))
+        {
+            run.kind=Indexed;
+            const LogRangeReader::Window &overview=data.overview(index);
+            list<<writeArray(file,overview.time);
+            for(int c=0;c<LogRangeReader::ColumnCount;c++)
+                list<<writeArray(file,overview.columns[c]);
+            list<<writeArray(file,data.source(index)->timeIndex());
+        }
+        blocks<<list;
+    }
+    const qint64 metaOffset=file.pos();
+    QDataStream stream(&file);
+    stream<<layout.channels<<layout.derived<<layout.reference<<qint32(layout.comparisonMode)<<qint32(layout.overlayMode);
+    stream<<quint32(written.size());
+    for(int i=0;i<written.size();i++)
+    {
+        const Run &run=written[i];
+        stream<<run.name<<run.path<<run.color<<run.size<<run.modified<<qint32(run.kind)<<quint32(blocks[i].size());
+        for(int b=0;b<blocks[i].size();b++)
+            stream<<blocks[i][b].offset<<blocks[i][b].count<<blocks[i][b].elementSize;
+    }
+    file.seek(0);
+    stream<<KSnapshotMagic<<KSnapshotVersion;
+    file.write((const char*)&KByteOrderMark,sizeof(KByteOrderMark));
+    stream<<quint32(0)<<metaOffset;
+    if(stream.status()!=QDataStream::Ok || file.error()!=QFile::NoError)
+    {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool SessionSnapshot::open(const QString &fileName)
+{
+    close();
+    m_file.setFileName(fileName);
+    if(!m_file.open(QIODevice::ReadOnly) || m_file.size()<KHeaderSize)
+    {
+        close();
+        return false;
+    }
+    m_data=m_file.map(0,m_file.size());
+    if(!m_data)
+    {
+        close();
+        return false;
+    }
+    QDataStream header(QByteArray::fromRawData((const char*)m_data,KHeaderSize));
+    quint32 magic,version,mark,reserved;
+    qint64 metaOffset;
+    header>>magic>>version;
+    memcpy(&mark,m_data+8,sizeof(mark));
+    header.skipRawData(sizeof(mark));
+    header>>reserved>>metaOffset;
+    //снимок с машины с другим порядком байт не читается: массивы в нём не переставлены
+    if(magic!=KSnapshotMagic || version!=KSnapshotVersion || mark!=KByteOrderMark || metaOffset<KHeaderSize || metaOffset>m_file.size())
+    {
+        close();
+        return false;
+    }
+    m_arraysEnd=metaOffset;
+    QDataStream stream(QByteArray::fromRawData((const char*)m_data+metaOffset,int(m_file.size()-metaOffset)));
+    qint32 comparisonMode,overlayMode;
+    quint32 count;
+    stream>>m_layout.channels>>m_layout.derived>>m_layout.reference>>comparisonMode>>overlayMode>>count;
+    m_layout.comparisonMode=comparisonMode;
+    m_layout.overlayMode=overlayMode;
+    for(quint32 i=0;i<count && stream.status()==QDataStream::Ok;i++)
+    {
+        Run run;
+        qint32 kind;
+        quint32 blockCount;
+        stream>>run.name>>run.path>>run.color>>run.size>>run.modified>>kind>>blockCount;
+        if(blockCount>KMaxBlocks)
+            break;
+        QVector<Block> blocks(blockCount);
+        for(quint32 b=0;b<blockCount;b++)
+            stream>>blocks[b].offset>>blocks[b].count>>blocks[b].elementSize;
+        run.kind=kind;
+        QFileInfo info(run.path);
+        run.stale=!info.exists() || info.size()!=run.size || info.lastModified().toMSecsSinceEpoch()!=run.modified;
+        m_runs<<run;
+        m_blocks<<blocks;
+    }
+    if(stream.status()!=QDataStream::Ok || quint32(m_runs.size())!=count)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SessionSnapshot::close()
+{
+    if(m_data)
+        m_file.unmap(const_cast<uchar*>(m_data));
+    m_data=0;
+    m_file.close();
+    m_arraysEnd=0;
+    m_layout=Layout();
+    m_runs.clear();
+    m_blocks.clear();
+}
+
+template<typename T>
+bool SessionSnapshot::array(const Block &block, QVector<T> &out) const
+{
+    if(block.elementSize!=int(sizeof(T)) || block.count<0 || block.offset<KHeaderSize
+            || block.offset+qint64(block.count)*block.elementSize>m_arraysEnd)
+        return false;
+    out.resize(block.count);
+    memcpy(out.data(),m_data+block.offset,size_t(block.count)*sizeof(T));
+    return true;
+}
+
+bool SessionSnapshot::restore(int run, GraphData &data) const
+{
+    const Run &info=m_runs[run];
+    const QVector<Block> &blocks=m_blocks[run];
+    if(info.stale)
+        return false;
+    if(info.kind==Full && blocks.size()==GraphData::ChannelCount+3)
+    {
+        QVector<double> time;
+        QVector<QVector<float> > channels(GraphData::ChannelCount);
+        QVector<float> positionX;
+        QVector<float> positionZ;
+        bool ok=array(blocks[0],time);
+        for(int c=0;c<GraphData::ChannelCount;c++)
+            ok=ok && array(blocks[1+c],channels[c]);
+        ok=ok && array(blocks[GraphData::ChannelCount+1],positionX) && array(blocks[GraphData::ChannelCount+2],positionZ);
+        return ok && data.restore(info.name,time,channels,positionX,positionZ);
+    }
+    if(info.kind==Indexed && blocks.size()==LogRangeReader::ColumnCount+2)
+    {
+        LogRangeReader::Window overview;
+        QVector<double> timeIndex;
+        bool ok=array(blocks[0],overview.time);
+        for(int c=0;c<LogRangeReader::ColumnCount;c++)
+            ok=ok && array(blocks[1+c],overview.columns[c]);
+        ok=ok && array(blocks[LogRangeReader::ColumnCount+1],timeIndex);
+        overview.downsampled=overview.time.size()<timeIndex.size();
+        //лог отображается заново, но не читается: индекс времени уже готов
+        return ok && data.attach(info.name,info.path,overview,timeIndex);
+    }
+    return false;
+}
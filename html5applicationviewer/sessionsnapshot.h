@@ -0,0 +1,71 @@
+#ifndef SESSIONSNAPSHOT_H
+#define SESSIONSNAPSHOT_H
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QColor>
+#include <QList>
+#include <QVector>
+
+#include "graphdata.h"
+
+//Снимок сессии в одном файле: выбранные прогоны с уже разобранными столбцами
+//(для больших логов - обзор и индекс времени), цвета, отмеченные каналы и режимы графиков.
+//Столбцы лежат сырыми массивами, файл отображается в память и копируется в GraphData
+//целыми массивами, без разбора записей. Прогон, чей лог изменился после сохранения
+//(размер или дата), из снимка не берётся и читается из лога заново
+class SessionSnapshot
+{
+public:
+    enum Kind{PathOnly,Full,Indexed};//Indexed - обзор большого лога и индекс времени
+
+    struct Run
+    {
+        QString name;
+        QString path;
+        QColor color;
+        qint64 size;
+        qint64 modified;//мс от эпохи
+        int kind;
+        bool stale;//лог изменился или пропал
+    };
+
+    struct Layout
+    {
+        QList<int> channels;//отмеченные каналы, в том числе производные
+        QStringList derived;//выражения производных каналов по порядку
+        QString reference;//опорный прогон сравнения
+        int comparisonMode;
+        int overlayMode;
+    };
+
+    SessionSnapshot();
+    ~SessionSnapshot();
+
+    static bool save(const QString &fileName,GraphData &data,const QList<Run> &runs,const Layout &layout);
+
+    bool open(const QString &fileName);
+    void close();
+    const Layout &layout() const {return m_layout;}
+    const QList<Run> &runs() const {return m_runs;}
+    bool restore(int run,GraphData &data) const;//false - прогон нужно читать из лога
+
+    struct Block
+    {
+        qint64 offset;
+        qint32 count;
+        qint32 elementSize;
+    };
+
+private:
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_arraysEnd;//массивы лежат между заголовком и оглавлением
+    Layout m_layout;
+    QList<Run> m_runs;
+    QList<QVector<Block> > m_blocks;
+    template<typename T> bool array(const Block &block,QVector<T> &out) const;
+};
+
+#endif // SESSIONSNAPSHOT_H
@@ -0,0 +1,216 @@
+#include "sharedring.h"
+#include "livestream.h"
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <new>
+
+static const quint32 KRingMagic = 0x47565352;//"GVSR"
+static const int KMaxRunName = 128;
+static const int KCacheLine = 64;
+static const quint32 KMaxCapacity = 1<<20;//слотов; сегмент должен поместиться в int QSharedMemory
+
+//индексы в разных процессах работают через один сегмент, поэтому атомики обязаны быть без блокировок
+static_assert(ATOMIC_LLONG_LOCK_FREE==2,"shared ring needs address-free 64-bit atomics");
+
+struct SharedRingHeader
+{
+    quint32 magic;
+    quint32 version;//DATASET_VERSION писателя
+    quint32 slotSize;//sizeof(DataSet) писателя
+    quint32 capacity;//степень двойки
+    char run[KMaxRunName];//UTF-8 с завершающим нулём
+    alignas(KCacheLine) std::atomic<quint64> head;//пишет только писатель
+    std::atomic<quint64> dropped;
+    std::atomic<quint32> finished;
+    alignas(KCacheLine) std::atomic<quint64> tail;//пишет только читатель
+};
+
+static qint64 alignedToCacheLine(qint64 offset)
+{
+    return (offset+KCacheLine-1)/KCacheLine*KCacheLine;
+}
+
+static qint64 slotsOffset()
+{
+    return alignedToCacheLine(sizeof(SharedRingHeader));
+}
+
+static qint64 sendTimesOffset(quint32 capacity)
+{
+    return alignedToCacheLine(slotsOffset()+qint64(capacity)*qint64(sizeof(DataSet)));
+}
+
+static qint64 segmentSize(quint32 capacity)
+{
+    return sendTimesOffset(capacity)+qint64(capacity)*qint64(sizeof(qint64));
+}
+
+SharedRing::SharedRing()
+    : m_mode(Closed)
+    , m_header(0)
+    , m_capacity(0)
+    , m_slots(0)
+    , m_sendTimes(0)
+{
+
+}
+
+SharedRing::~SharedRing()
+{
+    close();
+}
+
+bool SharedRing::create(const QString &key, const QString &run, int capacity)
+{
+    close();
+    quint32 size=1;
+    while(size<quint32(qBound(1,capacity,int(KMaxCapacity))))
+        size<<=1;
+    if(segmentSize(size)>INT_MAX)
+        return false;
+    m_memory.setKey(key);
+    //сегмент от упавшего писателя: подключение и отключение удаляет его, если читателя нет
+    if(m_memory.attach())
+        m_memory.detach();
+    if(!m_memory.create(int(segmentSize(size))))
+        return false;
+    m_memory.lock();
+    char *base=(char*)m_memory.data();
+    memset(base,0,slotsOffset());
+    SharedRingHeader *header=new(base) SharedRingHeader;
+    header->magic=KRingMagic;
+    header->version=DATASET_VERSION;
+    header->slotSize=sizeof(DataSet);
+    header->capacity=size;
+    QByteArray name=run.toUtf8().left(KMaxRunName-1);
+    memcpy(header->run,name.constData(),name.size());
+    header->head.store(0);
+    header->tail.store(0);
+    header->dropped.store(0);
+    header->finished.store(0);
+    m_memory.unlock();
+    m_mode=Write;
+    m_capacity=size;
+    map();
+    return true;
+}
+
+bool SharedRing::attach(const QString &key)
+{
+    close();
+    m_memory.setKey(key);
+    if(!m_memory.attach())
+        return false;
+    //заголовок заполняется писателем под блокировкой; ёмкость читается один раз и дальше
+    //берётся из копии - сегмент чужого процесса может измениться в любой момент
+    bool valid=m_memory.size()>=slotsOffset();
+    quint32 capacity=0;
+    if(valid)
+    {
+        m_memory.lock();
+        const SharedRingHeader *header=(const SharedRingHeader*)m_memory.constData();
+        //кольцо другой версии формата или другой сборки DataSet читать нельзя
+        valid=header->magic==KRingMagic && header->version==DATASET_VERSION && header->slotSize==sizeof(DataSet);
+        capacity=header->capacity;
+        m_memory.unlock();
+    }
+    valid=valid && capacity!=0 && capacity<=KMaxCapacity && (capacity&(capacity-1))==0
+            && m_memory.size()>=segmentSize(capacity);
+    if(!valid)
+    {
+        m_memory.detach();
+        return false;
+    }
+    m_mode=Read;
+    m_capacity=capacity;
+    map();
+    return true;
+}
+
+void SharedRing::map()
+{
+    char *base=(char*)m_memory.data();
+    m_header=(SharedRingHeader*)base;
+    m_slots=(DataSet*)(base+slotsOffset());
+    m_sendTimes=(qint64*)(base+sendTimesOffset(m_capacity));
+    Q_ASSERT(quintptr(m_slots)%alignof(DataSet)==0 && quintptr(m_sendTimes)%alignof(qint64)==0);
+}
+
+void SharedRing::close()
+{
+    if(m_mode==Write)
+        m_header->finished.store(1,std::memory_order_release);
+    if(m_memory.isAttached())
+        m_memory.detach();
+    m_mode=Closed;
+    m_header=0;
+    m_capacity=0;
+    m_slots=0;
+    m_sendTimes=0;
+}
+
+int SharedRing::push(const DataSet *records, int count)
+{
+    if(m_mode!=Write)
+        return 0;
+    const quint64 mask=m_capacity-1;
+    const quint64 head=m_header->head.load(std::memory_order_relaxed);
+    const quint64 free=m_capacity-(head-m_header->tail.load(std::memory_order_acquire));
+    const int accepted=int(qMin(free,quint64(count)));
+    const qint64 now=LiveStream::now();
+    for(int i=0;i<accepted;i++)
+    {
+        m_slots[(head+i)&mask]=records[i];
+        m_sendTimes[(head+i)&mask]=now;
+    }
+    if(accepted<count)
+        m_header->dropped.fetch_add(count-accepted,std::memory_order_relaxed);
+    m_header->head.store(head+accepted,std::memory_order_release);
+    return accepted;
+}
+
+int SharedRing::peek(const DataSet *&records, qint64 &sendTime) const
+{
+    if(m_mode!=Read)
+        return 0;
+    const quint64 mask=m_capacity-1;
+    const quint64 tail=m_header->tail.load(std::memory_order_relaxed);
+    //голова из чужого процесса: больше ёмкости кольца записей быть не может
+    const quint64 available=qMin(m_header->head.load(std::memory_order_acquire)-tail,quint64(m_capacity));
+    //до конца сегмента, остаток после переноса - следующим вызовом
+    const int count=int(qMin(available,quint64(m_capacity-(tail&mask))));
+    records=m_slots+(tail&mask);
+    if(count>0)
+        sendTime=m_sendTimes[tail&mask];//самая старая запись - худшая задержка
+    return count;
+}
+
+void SharedRing::release(int count)
+{
+    if(m_mode!=Read)
+        return;
+    const quint64 tail=m_header->tail.load(std::memory_order_relaxed);
+    m_header->tail.store(tail+count,std::memory_order_release);
+}
+
+bool SharedRing::isFinished() const
+{
+    return m_header && m_header->finished.load(std::memory_order_acquire);
+}
+
+QString SharedRing::run() const
+{
+    return m_header ? QString::fromUtf8(m_header->run,qstrnlen(m_header->run,KMaxRunName)) : QString();
+}
+
+quint64 SharedRing::lag() const
+{
+    return m_header ? m_header->head.load(std::memory_order_acquire)-m_header->tail.load(std::memory_order_acquire) : 0;
+}
+
+quint64 SharedRing::dropped() const
+{
+    return m_header ? m_header->dropped.load(std::memory_order_relaxed) : 0;
+}
+
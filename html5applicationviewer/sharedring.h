@@ -0,0 +1,51 @@
+#ifndef SHAREDRING_H
+#define SHAREDRING_H
+
+#include <QSharedMemory>
+#include <QString>
+
+#include "common.h"
+
+//Передача записей от симулятора без сериализации: кольцо слотов DataSet в разделяемой памяти
+//с одним писателем и одним читателем, как SpscRingBuffer, но между процессами. В заголовке
+//сегмента - DATASET_VERSION и размер слота: читатель другой сборки не подключится.
+//Писатель никогда не ждёт - если читатель отстал на всё кольцо, новые записи отбрасываются
+//и считаются. Читатель берёт записи прямо из сегмента (peek), затем освобождает слоты (release)
+class SharedRing
+{
+public:
+    enum Mode{Closed,Read,Write};
+
+    SharedRing();
+    ~SharedRing();
+
+    //писатель
+    bool create(const QString &key,const QString &run,int capacity);
+    int push(const DataSet *records,int count);//сколько принято, остальное отброшено
+    bool push(const DataSet &dataset) {return push(&dataset,1)==1;}
+
+    //читатель
+    bool attach(const QString &key);
+    int peek(const DataSet *&records,qint64 &sendTime) const;//подряд лежащие слоты; время отправки первого, самого старого
+    void release(int count);
+    bool isFinished() const;//писатель закрыл кольцо
+
+    void close();
+    Mode mode() const {return m_mode;}
+    QString run() const;
+    quint64 lag() const;//записей записано, но не прочитано
+    quint64 dropped() const;
+    int capacity() const {return m_capacity;}
+    QString errorString() const {return m_memory.errorString();}
+
+private:
+    QSharedMemory m_memory;
+    Mode m_mode;
+    struct SharedRingHeader *m_header;
+    quint32 m_capacity;//копия из заголовка, проверенная при подключении
+    DataSet *m_slots;
+    qint64 *m_sendTimes;//мкс LiveStream::now() по слотам
+    void map();
+};
+
+#endif // SHAREDRING_H
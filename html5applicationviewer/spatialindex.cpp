@@ -0,0 +1,118 @@
+#include "spatialindex.h"
+#include <qnumeric.h>
+#include <cmath>
+#include <limits>
+
+static const int KPointsPerCell = 16;
+static const int KMaxCells = 1<<22;
+
+SpatialIndex::SpatialIndex()
+    : m_minX(0)
+    , m_minY(0)
+    , m_maxX(0)
+    , m_maxY(0)
+    , m_cellSize(1)
+    , m_columns(0)
+    , m_rows(0)
+{
+
+}
+
+void SpatialIndex::build(const QVector<float> &x, const QVector<float> &y)
+{
+    m_x=x;
+    m_y=y;
+    const int n=x.size();
+    m_minX=m_minY=std::numeric_limits<float>::max();
+    m_maxX=m_maxY=-std::numeric_limits<float>::max();
+    int finite=0;
+    for(int i=0;i<n;i++)
+    {
+        if(!qIsFinite(x[i]) || !qIsFinite(y[i]))
+            continue;
+        m_minX=qMin(m_minX,x[i]);
+        m_maxX=qMax(m_maxX,x[i]);
+        m_minY=qMin(m_minY,y[i]);
+        m_maxY=qMax(m_maxY,y[i]);
+        finite++;
+    }
+    if(finite==0)
+    {
+        m_minX=m_minY=m_maxX=m_maxY=0;
+        m_columns=m_rows=0;
+        m_cellStart.clear();
+        m_points.clear();
+        return;
+    }
+    const double width=qMax(1e-6,double(m_maxX-m_minX));
+    const double height=qMax(1e-6,double(m_maxY-m_minY));
+    const int cells=qBound(1,finite/KPointsPerCell,KMaxCells);
+    m_cellSize=float(qMax(std::sqrt(width*height/cells),qMax(width,height)/KMaxCells));
+    m_columns=int(width/m_cellSize)+1;
+    m_rows=int(height/m_cellSize)+1;
+
+    //сортировка подсчётом по номеру ячейки
+    m_cellStart.fill(0,m_columns*m_rows+1);
+    for(int i=0;i<n;i++)
+        if(qIsFinite(x[i]) && qIsFinite(y[i]))
+            m_cellStart[cellOf(x[i],y[i])+1]++;
+    for(int c=0;c<m_columns*m_rows;c++)
+        m_cellStart[c+1]+=m_cellStart[c];
+    QVector<int> fill=m_cellStart;
+    m_points.resize(finite);
+    for(int i=0;i<n;i++)
+        if(qIsFinite(x[i]) && qIsFinite(y[i]))
+            m_points[fill[cellOf(x[i],y[i])]++]=i;
+}
+
+int SpatialIndex::cellOf(float x, float y) const
+{
+    int column=qBound(0,int((x-m_minX)/m_cellSize),m_columns-1);
+    int row=qBound(0,int((y-m_minY)/m_cellSize),m_rows-1);
+    return row*m_columns+column;
+}
+
+int SpatialIndex::nearest(float x, float y, float maxDistance) const
+{
+    if(m_columns==0)
+        return -1;
+    const int column=int(std::floor((x-m_minX)/m_cellSize));
+    const int row=int(std::floor((y-m_minY)/m_cellSize));
+    const int maxRing=int(maxDistance/m_cellSize)+1;
+    int best=-1;
+    float bestDistance=maxDistance*maxDistance;
+    //кольца ячеек вокруг точки, пока кольцо может содержать что-то ближе найденного
+    for(int ring=0;ring<=maxRing;ring++)
+    {
+        if(best!=-1 && (ring-1)*m_cellSize>std::sqrt(bestDistance))
+            break;
+        for(int r=row-ring;r<=row+ring;r++)
+        {
+            if(r<0 || r>=m_rows)
+                continue;
+            const bool edgeRow=(r==row-ring || r==row+ring);
+            for(int c=column-ring;c<=column+ring;c+=(edgeRow ? 1 : 2*ring))
+            {
+                if(c>=0 && c<m_columns)
+                {
+                    const int cell=r*m_columns+c;
+                    for(int k=m_cellStart[cell];k<m_cellStart[cell+1];k++)
+                    {
+                        const int i=m_points[k];
+                        const float dx=m_x[i]-x;
+                        const float dy=m_y[i]-y;
+                        const float d=dx*dx+dy*dy;
+                        if(d<=bestDistance)
+                        {
+                            bestDistance=d;
+                            best=i;
+                        }
+                    }
+                }
+                if(ring==0)
+                    break;
+            }
+        }
+    }
+    return best;
+}
@@ -0,0 +1,37 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <QVector>
+
+//Равномерная сетка над точками траектории: поиск ближайшей точки
+//просматривает только соседние ячейки, а не все отсчёты прогона
+class SpatialIndex
+{
+public:
+    SpatialIndex();
+
+    void build(const QVector<float> &x,const QVector<float> &y);
+    int size() const {return m_x.size();}
+    int nearest(float x,float y,float maxDistance) const;//-1, если ближе maxDistance ничего нет
+
+    float minX() const {return m_minX;}
+    float minY() const {return m_minY;}
+    float maxX() const {return m_maxX;}
+    float maxY() const {return m_maxY;}
+
+private:
+    QVector<float> m_x;
+    QVector<float> m_y;
+    QVector<int> m_cellStart;//ячейка c занимает m_points[m_cellStart[c]..m_cellStart[c+1])
+    QVector<int> m_points;
+    float m_minX;
+    float m_minY;
+    float m_maxX;
+    float m_maxY;
+    float m_cellSize;
+    int m_columns;
+    int m_rows;
+    int cellOf(float x,float y) const;
+};
+
+#endif // SPATIALINDEX_H
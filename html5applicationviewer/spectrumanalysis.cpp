@@ -0,0 +1,111 @@
+#include "spectrumanalysis.h"
+#include "resample.h"
+#include "fft.h"
+#include <qnumeric.h>
+#include <algorithm>
+#include <cmath>
+
+static const int KMaxColumns = 2048;
+static const int KTimestepSamples = 4096;
+static const int KMaxGridFactor = 4;//узлов сетки на отсчёт канала, больше - прогон с паузами
+static const double KPi = 3.14159265358979323846;
+
+static double medianTimestep(const QVector<double> &time)
+{
+    QVector<double> steps;
+    const int step=qMax(1,time.size()/KTimestepSamples);
+    for(int i=step;i<time.size();i+=step)
+        if(time[i]>time[i-1])
+            steps.append(time[i]-time[i-1]);
+    if(steps.isEmpty())
+        return 1;
+    std::nth_element(steps.begin(),steps.begin()+steps.size()/2,steps.end());
+    return steps[steps.size()/2];
+}
+
+SpectrumAnalysis::Result SpectrumAnalysis::compute(QVector<double> time, QVector<float> values, int window)
+{
+    Result r;
+    r.sampleCount=values.size();
+    r.window=window;
+    r.bins=window/2+1;
+    r.columns=0;
+    r.sampleRate=0;
+    r.tStart=time.isEmpty() ? 0 : time.first();
+    r.columnStep=0;
+    r.minDb=r.maxDb=0;
+    r.status=TooShort;
+    if(values.size()<window)
+        return r;
+
+    const double dt=medianTimestep(time);
+    //длинные паузы растянули бы сетку далеко за число отсчётов, считаем в double до приведения
+    const double span=(time.last()-time.first())/dt+1;
+    if(span>double(KMaxGridFactor)*values.size())
+    {
+        r.status=TooSparse;
+        return r;
+    }
+    const int m=int(span);
+    if(m<window)
+        return r;
+    r.status=Ok;
+    QVector<double> grid(m);
+    for(int i=0;i<m;i++)
+        grid[i]=time.first()+i*dt;
+    QVector<float> uniform=resample(time,values,grid);
+    double sum=0;
+    int count=0;
+    for(int i=0;i<m;i++)
+        if(qIsFinite(uniform[i]))
+        {
+            sum+=uniform[i];
+            count++;
+        }
+    const float mean=count ? float(sum/count) : 0.0f;
+    for(int i=0;i<m;i++)
+        if(!qIsFinite(uniform[i]))
+            uniform[i]=mean;
+
+    int hop=window/2;
+    if((m-window)/hop+1>KMaxColumns)
+        hop=(m-window)/(KMaxColumns-1);
+    r.columns=(m-window)/hop+1;
+    r.sampleRate=1/dt;
+    r.columnStep=hop*dt;
+
+    QVector<float> hann(window);
+    for(int i=0;i<window;i++)
+        hann[i]=float(0.5-0.5*std::cos(2*KPi*i/(window-1)));
+    const double norm=2.0/window;
+
+    r.spectrogram.resize(r.columns*r.bins);
+    QVector<double> power(r.bins,0.0);
+    QVector<std::complex<float> > buffer(window);
+    for(int c=0;c<r.columns;c++)
+    {
+        const float *segment=uniform.constData()+c*hop;
+        double segmentMean=0;
+        for(int i=0;i<window;i++)
+            segmentMean+=segment[i];
+        segmentMean/=window;
+        for(int i=0;i<window;i++)
+            buffer[i]=std::complex<float>(float((segment[i]-segmentMean)*hann[i]),0);
+        fft(buffer.data(),window);
+        float *column=r.spectrogram.data()+c*r.bins;
+        for(int k=0;k<r.bins;k++)
+        {
+            const double magnitude=std::abs(buffer[k])*norm;
+            power[k]+=magnitude*magnitude;
+            column[k]=float(20*std::log10(magnitude+1e-12));
+        }
+    }
+
+    r.spectrum.resize(r.bins);
+    for(int k=0;k<r.bins;k++)
+        r.spectrum[k]=float(10*std::log10(power[k]/r.columns+1e-24));
+    //нижняя граница шкалы - на 80 дБ ниже максимума, иначе шум забивает картинку
+    r.maxDb=*std::max_element(r.spectrogram.constBegin(),r.spectrogram.constEnd());
+    r.minDb=r.maxDb-80;
+    return r;
+}
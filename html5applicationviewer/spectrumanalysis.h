@@ -0,0 +1,32 @@
+#ifndef SPECTRUMANALYSIS_H
+#define SPECTRUMANALYSIS_H
+
+#include <QVector>
+
+//Спектр и спектрограмма канала. Отсчёты пересчитываются на равномерную сетку
+//с шагом медианного physics_timestep, поэтому частоты получаются в герцах
+class SpectrumAnalysis
+{
+public:
+    enum Status{Ok,TooShort,TooSparse};//TooSparse - отсчёты слишком неравномерны для сетки
+
+    struct Result
+    {
+        Status status;
+        int sampleCount;//размер исходного канала, для проверки актуальности кэша
+        int window;
+        int bins;
+        int columns;
+        double sampleRate;
+        double tStart;
+        double columnStep;//секунд между соседними столбцами спектрограммы
+        float minDb;
+        float maxDb;
+        QVector<float> spectrum;//средний спектр, дБ
+        QVector<float> spectrogram;//columns x bins, дБ
+    };
+
+    static Result compute(QVector<double> time,QVector<float> values,int window);
+};
+
+#endif // SPECTRUMANALYSIS_H
@@ -0,0 +1,232 @@
+#include "spectrumview.h"
+#include <QGridLayout>
+#include <QPainter>
+#include <QMouseEvent>
+
+#include "taskscheduler.h"
+
+namespace
+{
+struct SpectrumTask
+{
+    typedef SpectrumAnalysis::Result result_type;
+    QVector<double> time;
+    QVector<float> values;
+    int window;
+    result_type operator()(const TaskScheduler::Token &) const {return SpectrumAnalysis::compute(time,values,window);}
+};
+}
+
+SpectrumCanvas::SpectrumCanvas(QWidget *parent)
+    : QWidget(parent)
+    , m_result(0)
+    , m_image(0)
+    , m_column(-1)
+{
+    setMouseTracking(true);
+    setMinimumSize(300,300);
+}
+
+void SpectrumCanvas::setResult(const SpectrumAnalysis::Result *result, const QImage *image)
+{
+    m_result=result;
+    m_image=image;
+    m_column=-1;
+    update();
+}
+
+QRect SpectrumCanvas::spectrogramRect() const
+{
+    return QRect(0,0,width(),height()*3/5);
+}
+
+QRect SpectrumCanvas::spectrumRect() const
+{
+    return QRect(0,height()*3/5+4,width(),height()-height()*3/5-4);
+}
+
+void SpectrumCanvas::mouseMoveEvent(QMouseEvent *event)
+{
+    if(!m_result || m_result->columns==0 || !spectrogramRect().contains(event->pos()))
+        return;
+    int column=event->pos().x()*m_result->columns/qMax(1,width());
+    if(column!=m_column)
+    {
+        m_column=qBound(0,column,m_result->columns-1);
+        update();
+    }
+}
+
+void SpectrumCanvas::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(),Qt::white);
+    if(!m_result || m_result->columns==0)
+        return;
+    QRect top=spectrogramRect();
+    QRect bottom=spectrumRect();
+    painter.drawImage(top,*m_image);
+
+    const float *values=m_column<0 ? m_result->spectrum.constData() : m_result->spectrogram.constData()+m_column*m_result->bins;
+    const float range=qMax(1.0f,m_result->maxDb-m_result->minDb);
+    QPolygonF line;
+    int peak=1;
+    for(int k=0;k<m_result->bins;k++)
+    {
+        float v=qBound(0.0f,(values[k]-m_result->minDb)/range,1.0f);
+        line<<QPointF(bottom.left()+double(k)*bottom.width()/(m_result->bins-1),bottom.bottom()-v*bottom.height());
+        if(k>0 && values[k]>values[peak])
+            peak=k;
+    }
+    painter.setPen(Qt::darkGray);
+    painter.drawRect(bottom.adjusted(0,0,-1,-1));
+    painter.setPen(Qt::blue);
+    painter.drawPolyline(line);
+
+    QString text;
+    if(m_column>=0)
+    {
+        int x=top.left()+(2*m_column+1)*top.width()/(2*m_result->columns);
+        painter.setPen(Qt::white);
+        painter.drawLine(x,top.top(),x,top.bottom());
+        text=QString("t = %1 s, ").arg(m_result->tStart+m_column*m_result->columnStep,0,'f',3);
+    }
+    else
+        text="average, ";
+    text+=QString("peak %1 Hz, Nyquist %2 Hz").arg(peak*m_result->sampleRate/m_result->window,0,'f',3).arg(m_result->sampleRate/2,0,'f',3);
+    painter.setPen(Qt::black);
+    painter.drawText(bottom.adjusted(4,2,-4,-2),Qt::AlignTop|Qt::AlignLeft,text);
+}
+
+SpectrumView::SpectrumView(GraphData &data, QWidget *parent)
+    : QWidget(parent,Qt::Window)
+    , m_data(data)
+{
+    setWindowTitle(tr("Spectrum"));
+    m_run=new QComboBox;
+    m_channel=new QComboBox;
+    m_window=new QComboBox;
+    for(int size=256;size<=8192;size*=2)
+        m_window->addItem(QString::number(size),size);
+    m_window->setCurrentIndex(2);
+    m_status=new QLabel;
+    m_canvas=new SpectrumCanvas;
+    QGridLayout *layout=new QGridLayout;
+    layout->addWidget(m_run,0,0);
+    layout->addWidget(m_channel,0,1);
+    layout->addWidget(m_window,0,2);
+    layout->addWidget(m_canvas,1,0,1,3);
+    layout->addWidget(m_status,2,0,1,3);
+    setLayout(layout);
+    connect(m_run,SIGNAL(activated(int)),SLOT(request()));
+    connect(m_channel,SIGNAL(activated(int)),SLOT(request()));
+    connect(m_window,SIGNAL(activated(int)),SLOT(request()));
+    connect(&m_watcher,SIGNAL(finished()),SLOT(computed()));
+    m_cache.setMaxCost(KCacheBytes);
+    resize(600,500);
+}
+
+void SpectrumView::refreshLists(const QStringList &channelNames)
+{
+    QString run=m_run->currentText();
+    int channel=m_channel->currentIndex();
+    m_run->clear();
+    for(int i=0;i<m_data.length();i++)
+        m_run->addItem(m_data.get_name(i));
+    m_channel->clear();
+    m_channel->addItems(channelNames);
+    m_run->setCurrentIndex(qMax(0,m_run->findText(run)));
+    m_channel->setCurrentIndex(qMax(0,channel));
+    request();
+}
+
+QString SpectrumView::currentKey()
+{
+    return m_run->currentText()+"|"+QString::number(m_channel->currentIndex())+"|"+m_window->currentText();
+}
+
+void SpectrumView::request()
+{
+    int index=m_data.findByName(m_run->currentText());
+    if(index==-1 || m_channel->currentIndex()<0)
+    {
+        m_canvas->setResult(0,0);
+        m_status->setText(tr("No run loaded"));
+        return;
+    }
+    QString key=currentKey();
+    const QVector<float> &values=m_data.column(index,m_channel->currentIndex());
+    const Entry *entry=m_cache.object(key);
+    if(entry && entry->result.sampleCount==values.size())
+    {
+        display(*entry);
+        return;
+    }
+    //пока идёт расчёт, новый запрос будет запущен из computed()
+    if(m_watcher.isRunning())
+        return;
+    m_pendingKey=key;
+    m_canvas->setResult(0,0);
+    m_status->setText(tr("Computing..."));
+    SpectrumTask task;
+    task.time=m_data.time(index);
+    task.values=values;
+    task.window=m_window->itemData(m_window->currentIndex()).toInt();
+    m_watcher.setFuture(TaskScheduler::run(TaskScheduler::VisibleRuns,task));
+}
+
+void SpectrumView::computed()
+{
+    Entry *entry=new Entry;
+    entry->result=m_watcher.result();
+    entry->image=render(entry->result);
+    const int cost=entry->result.spectrogram.size()*sizeof(float)+entry->image.byteCount();
+    //результат дороже всего кэша не кэшируется, но показывается
+    if(cost>KCacheBytes && m_pendingKey==currentKey())
+    {
+        display(*entry);
+        delete entry;
+        return;
+    }
+    m_cache.insert(m_pendingKey,entry,cost);
+    request();
+}
+
+void SpectrumView::display(const Entry &entry)
+{
+    m_shown=entry;
+    m_canvas->setResult(&m_shown.result,&m_shown.image);
+    if(m_shown.result.status==SpectrumAnalysis::TooShort)
+        m_status->setText(tr("Run is shorter than the window"));
+    else if(m_shown.result.status==SpectrumAnalysis::TooSparse)
+        m_status->setText(tr("Samples are too irregular for a uniform grid"));
+    else
+        m_status->setText(tr("%1 columns, %2 Hz sample rate").arg(m_shown.result.columns).arg(m_shown.result.sampleRate));
+}
+
+void SpectrumView::invalidate(const QString &run)
+{
+    const QString prefix=run+"|";
+    QList<QString> keys=m_cache.keys();
+    for(int i=0;i<keys.size();i++)
+        if(keys[i].startsWith(prefix))
+            m_cache.remove(keys[i]);
+}
+
+QImage SpectrumView::render(const SpectrumAnalysis::Result &result)
+{
+    if(result.columns==0)
+        return QImage();
+    QImage image(result.columns,result.bins,QImage::Format_RGB32);
+    const float range=qMax(1.0f,result.maxDb-result.minDb);
+    for(int k=0;k<result.bins;k++)
+    {
+        QRgb *line=(QRgb*)image.scanLine(result.bins-1-k);
+        for(int c=0;c<result.columns;c++)
+        {
+            float v=qBound(0.0f,(result.spectrogram[c*result.bins+k]-result.minDb)/range,1.0f);
+            line[c]=qRgb(int(255*qMin(1.0f,3*v)),int(255*qBound(0.0f,3*v-1,1.0f)),int(255*qBound(0.0f,3*v-2,1.0f)));
+        }
+    }
+    return image;
+}
@@ -0,0 +1,63 @@
+#ifndef SPECTRUMVIEW_H
+#define SPECTRUMVIEW_H
+
+#include <QWidget>
+#include <QComboBox>
+#include <QLabel>
+#include <QImage>
+#include <QCache>
+#include <QFutureWatcher>
+
+#include "graphdata.h"
+#include "spectrumanalysis.h"
+
+//Область рисования: сверху спектрограмма, снизу спектр столбца под курсором
+class SpectrumCanvas : public QWidget
+{
+public:
+    explicit SpectrumCanvas(QWidget *parent = 0);
+    void setResult(const SpectrumAnalysis::Result *result,const QImage *image);
+protected:
+    void paintEvent(QPaintEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+private:
+    const SpectrumAnalysis::Result *m_result;
+    const QImage *m_image;
+    int m_column;//-1 - показывается средний спектр
+    QRect spectrogramRect() const;
+    QRect spectrumRect() const;
+};
+
+class SpectrumView : public QWidget
+{
+    Q_OBJECT
+public:
+    SpectrumView(GraphData &data,QWidget *parent = 0);
+    void refreshLists(const QStringList &channelNames);
+    void invalidate(const QString &run);//прогон закрыт или заменён
+private slots:
+    void request();
+    void computed();
+private:
+    static const int KCacheBytes = 64<<20;
+    struct Entry
+    {
+        SpectrumAnalysis::Result result;
+        QImage image;
+    };
+    GraphData &m_data;
+    QComboBox *m_run;
+    QComboBox *m_channel;
+    QComboBox *m_window;
+    QLabel *m_status;
+    SpectrumCanvas *m_canvas;
+    QCache<QString,Entry> m_cache;//прогон/канал/окно, стоимость - байты спектрограммы и картинки
+    Entry m_shown;//копия показываемого: вытеснение из кэша не трогает холст
+    QFutureWatcher<SpectrumAnalysis::Result> m_watcher;
+    QString m_pendingKey;
+    QString currentKey();
+    void display(const Entry &entry);
+    static QImage render(const SpectrumAnalysis::Result &result);
+};
+
+#endif // SPECTRUMVIEW_H
@@ -0,0 +1,68 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+#include <new>
+
+//Кольцевой буфер без блокировок для одного писателя и одного читателя.
+//Ёмкость округляется вверх до степени двойки
+template<class T>
+class SpscRingBuffer
+{
+public:
+    explicit SpscRingBuffer(int capacity)
+        : m_head(0)
+        , m_tail(0)
+    {
+        int size=1;
+        while(size<capacity)
+            size<<=1;
+        m_items.resize(size);
+        m_data=m_items.data();
+        m_mask=size-1;
+    }
+
+    bool push(const T &item)
+    {
+        const quint64 head=m_head.load(std::memory_order_relaxed);
+        if(head-m_tail.load(std::memory_order_acquire)>quint64(m_mask))
+            return false;
+        m_data[head&m_mask]=item;
+        m_head.store(head+1,std::memory_order_release);
+        return true;
+    }
+
+    int pop(T *out,int max)
+    {
+        const quint64 tail=m_tail.load(std::memory_order_relaxed);
+        const quint64 available=m_head.load(std::memory_order_acquire)-tail;
+        const int count=int(qMin(available,quint64(max)));
+        for(int i=0;i<count;i++)
+            out[i]=m_data[(tail+i)&m_mask];
+        m_tail.store(tail+count,std::memory_order_release);
+        return count;
+    }
+
+    int capacity() const {return m_mask+1;}
+
+    //до C++17 обычный new не учитывает alignas, а индексы должны лежать в разных строках кэша
+    static void *operator new(size_t size)
+    {
+        void *memory=qMallocAligned(size,alignof(SpscRingBuffer));
+        if(!memory)
+            throw std::bad_alloc();
+        return memory;
+    }
+    static void operator delete(void *memory) {qFreeAligned(memory);}
+
+private:
+    QVector<T> m_items;
+    T *m_data;
+    int m_mask;
+    alignas(64) std::atomic<quint64> m_head;//пишет только производитель
+    alignas(64) std::atomic<quint64> m_tail;//пишет только потребитель
+};
+
+#endif // SPSCRINGBUFFER_H
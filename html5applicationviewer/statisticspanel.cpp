@@ -0,0 +1,129 @@
+#include "statisticspanel.h"
+#include <QHeaderView>
+
+#include "taskscheduler.h"
+
+namespace
+{
+struct BuildTask
+{
+    typedef ChannelStatistics result_type;
+    QVector<float> values;
+    result_type operator()(const TaskScheduler::Token &) const
+    {
+        ChannelStatistics statistics;
+        statistics.build(values);
+        return statistics;
+    }
+};
+}
+
+StatisticsPanel::StatisticsPanel(QWidget *parent)
+    : QTableWidget(parent)
+    , m_data(0)
+{
+    QStringList header;
+    header<<"Run"<<"Channel"<<"Min"<<"Max"<<"Mean"<<"StdDev"<<"RMS"<<"P5"<<"P25"<<"P50"<<"P75"<<"P95"<<"RMSE (ref)"<<"MAE (ref)"<<"Max err (ref)";
+    setColumnCount(header.length());
+    setHorizontalHeaderLabels(header);
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setSelectionMode(QAbstractItemView::NoSelection);
+    verticalHeader()->hide();
+}
+
+void StatisticsPanel::refresh(GraphData &data, ComparisonEngine &comparison, const QList<int> &channels, const QStringList &channelNames, double tBegin, double tEnd)
+{
+    m_data=&data;
+    setRowCount(data.length()*channels.length());
+    int row=0;
+    for(int i=0;i<data.length();i++)
+    {
+        for(int j=0;j<channels.length();j++)
+        {
+            const bool ready=data.hasStatistics(i,channels[j]);
+            if(!ready)
+                build(data,i,channels[j]);
+            ChannelStatistics::Result r=data.statistics(i,channels[j],tBegin,tEnd);
+            double values[10]={r.min,r.max,r.mean,r.stddev,r.rms,r.p5,r.p25,r.p50,r.p75,r.p95};
+            setCell(row,0,data.get_name(i));
+            setCell(row,1,channelNames[channels[j]]);
+            for(int k=0;k<10;k++)
+                setCell(row,k+2,r.count ? QString::number(values[k],'g',6) : QString(ready ? "-" : "..."));
+            //оценки сравнения считаются по всему прогону, а не по видимому диапазону
+            if(comparison.isActive() && data.get_name(i)!=comparison.reference())
+            {
+                const ComparisonEngine::Result *result=comparison.result(data.get_name(i),channels[j]);
+                for(int k=0;k<3;k++)
+                {
+                    if(!result)
+                    {
+                        setCell(row,k+12,"...");
+                        continue;
+                    }
+                    const ComparisonEngine::Scores &scores=result->scores;
+                    double errors[3]={scores.rmse,scores.meanAbsError,scores.maxAbsError};
+                    setCell(row,k+12,scores.count ? QString::number(errors[k],'g',6) : QString("-"));
+                }
+            }
+            else
+                for(int k=0;k<3;k++)
+                    setCell(row,k+12,"-");
+            row++;
+        }
+    }
+}
+
+void StatisticsPanel::build(GraphData &data, int index, int channel)
+{
+    //столбец берётся здесь: производные каналы вычисляются только в потоке интерфейса
+    const QVector<float> &values=data.column(index,channel);
+    for(QHash<Watcher*,Pending>::iterator i=m_pending.begin();i!=m_pending.end();++i)
+    {
+        if(i->run!=data.get_name(index) || i->channel!=channel)
+            continue;
+        if(i->values.constData()==values.constData())
+            return;
+        //столбец изменился, пока строился прежний индекс: тот уже не нужен
+        Watcher *watcher=i.key();
+        m_pending.erase(i);
+        watcher->cancel();
+        disconnect(watcher,0,this,0);
+        connect(watcher,SIGNAL(finished()),watcher,SLOT(deleteLater()));
+        break;
+    }
+    Pending pending;
+    pending.run=data.get_name(index);
+    pending.channel=channel;
+    pending.values=values;
+    BuildTask task;
+    task.values=values;
+    Watcher *watcher=new Watcher(this);
+    connect(watcher,SIGNAL(finished()),SLOT(built()));
+    m_pending.insert(watcher,pending);
+    //таблица на экране, поэтому раньше упреждающей работы
+    watcher->setFuture(TaskScheduler::run(TaskScheduler::VisibleRuns,task));
+}
+
+void StatisticsPanel::built()
+{
+    Watcher *watcher=static_cast<Watcher*>(sender());
+    watcher->deleteLater();
+    Pending pending=m_pending.take(watcher);
+    if(watcher->isCanceled() || !m_data)
+        return;
+    int index=m_data->findByName(pending.run);
+    if(index==-1)
+        return;
+    m_data->setStatistics(index,pending.channel,pending.values,watcher->result());
+    emit indexed();
+}
+
+//при панорамировании таблица обновляется часто, поэтому ячейки переиспользуются
+void StatisticsPanel::setCell(int row, int column, const QString &text)
+{
+    QTableWidgetItem *cell=item(row,column);
+    if(cell)
+        cell->setText(text);
+    else
+        setItem(row,column,new QTableWidgetItem(text));
+}
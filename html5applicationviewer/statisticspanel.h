@@ -0,0 +1,38 @@
+#ifndef STATISTICSPANEL_H
+#define STATISTICSPANEL_H
+
+#include <QTableWidget>
+#include <QStringList>
+#include <QHash>
+#include <QFutureWatcher>
+
+#include "graphdata.h"
+#include "comparisonengine.h"
+
+//Индексы статистики строятся в фоне; пока индекс канала не готов, в строке многоточие,
+//по готовности - indexed(), и таблицу стоит обновить
+class StatisticsPanel : public QTableWidget
+{
+    Q_OBJECT
+public:
+    explicit StatisticsPanel(QWidget *parent = 0);
+    void refresh(GraphData &data,ComparisonEngine &comparison,const QList<int> &channels,const QStringList &channelNames,double tBegin,double tEnd);
+signals:
+    void indexed();
+private slots:
+    void built();
+private:
+    struct Pending
+    {
+        QString run;
+        int channel;
+        QVector<float> values;//копия столбца, по которой строится индекс
+    };
+    typedef QFutureWatcher<ChannelStatistics> Watcher;
+    GraphData *m_data;
+    QHash<Watcher*,Pending> m_pending;
+    void build(GraphData &data,int index,int channel);
+    void setCell(int row,int column,const QString &text);
+};
+
+#endif // STATISTICSPANEL_H
@@ -0,0 +1,63 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <QRunnable>
+#include <QThreadPool>
+#include <QFuture>
+#include <QFutureInterface>
+
+//Вся фоновая работа (загрузка, обзоры, анализ) идёт через общий пул потоков с приоритетами:
+//из очереди первыми берутся задачи для видимого диапазона, затем для видимых прогонов,
+//упреждающие - в последнюю очередь. Отмена - QFuture::cancel() (или QFutureWatcher::cancel()):
+//ещё не начатая задача не запускается вовсе, долгая проверяет Token между порциями работы
+class TaskScheduler
+{
+public:
+    enum Priority{Prefetch,VisibleRuns,VisibleRange};//больше - раньше
+
+    class Token
+    {
+    public:
+        explicit Token(const QFutureInterfaceBase &future) : m_future(future) {}
+        bool isCancelled() const {return m_future.isCanceled();}
+        //ход долгой задачи, наблюдателю приходит progressValueChanged
+        void reportProgress(int value,int maximum) const
+        {
+            m_future.setProgressRange(0,maximum);
+            m_future.setProgressValue(value);
+        }
+    private:
+        mutable QFutureInterfaceBase m_future;
+    };
+
+    //Functor: typedef result_type и result_type operator()(const Token &) const
+    template<typename Functor>
+    static QFuture<typename Functor::result_type> run(Priority priority,const Functor &functor)
+    {
+        Task<Functor> *task=new Task<Functor>(functor);
+        QFuture<typename Functor::result_type> future=task->future();
+        QThreadPool::globalInstance()->start(task,priority);
+        return future;
+    }
+
+private:
+    template<typename Functor>
+    class Task : public QRunnable
+    {
+    public:
+        explicit Task(const Functor &functor) : m_functor(functor) {m_future.reportStarted();}
+        QFuture<typename Functor::result_type> future() {return m_future.future();}
+        void run()
+        {
+            //результат отменённой задачи не сообщается, наблюдатель получает только finished
+            if(!m_future.isCanceled())
+                m_future.reportResult(m_functor(Token(m_future)));
+            m_future.reportFinished();
+        }
+    private:
+        QFutureInterface<typename Functor::result_type> m_future;
+        Functor m_functor;
+    };
+};
+
+#endif // TASKSCHEDULER_H
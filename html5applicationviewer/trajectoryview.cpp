@@ -0,0 +1,191 @@
+#include "trajectoryview.h"
+#include <QPainter>
+#include <QMouseEvent>
+#include <qnumeric.h>
+#include <algorithm>
+#include <cmath>
+
+static const int KMaxSegments = 200000;
+static const int KColorBuckets = 32;
+static const int KHoverRadius = 10;
+
+TrajectoryView::TrajectoryView(GraphData &data, QWidget *parent)
+    : QWidget(parent,Qt::Window)
+    , m_data(data)
+    , m_dirty(true)
+    , m_markerTime(qQNaN())
+    , m_minX(0)
+    , m_minY(0)
+    , m_scale(1)
+{
+    setWindowTitle(tr("Trajectory"));
+    setMouseTracking(true);
+    m_channel=new QComboBox(this);
+    m_channel->move(4,4);
+    connect(m_channel,SIGNAL(activated(int)),SLOT(channelChanged()));
+    resize(500,500);
+}
+
+void TrajectoryView::refreshLists(const QStringList &channelNames)
+{
+    int channel=m_channel->currentIndex();
+    m_channel->clear();
+    m_channel->addItems(channelNames);
+    m_channel->setCurrentIndex(qMax(0,channel));
+    m_channel->adjustSize();
+    dataChanged();
+}
+
+void TrajectoryView::dataChanged()
+{
+    m_dirty=true;
+    update();
+}
+
+void TrajectoryView::channelChanged()
+{
+    dataChanged();
+}
+
+void TrajectoryView::setMarkerTime(double t)
+{
+    m_markerTime=t;
+    update();
+}
+
+void TrajectoryView::resizeEvent(QResizeEvent *)
+{
+    m_dirty=true;
+}
+
+void TrajectoryView::ensureTracks()
+{
+    QVector<Track> tracks(m_data.length());
+    for(int i=0;i<m_data.length();i++)
+    {
+        tracks[i].name=m_data.get_name(i);
+        //индекс строится заново только для новых или изменившихся прогонов
+        for(int j=0;j<m_tracks.size();j++)
+            if(m_tracks[j].name==tracks[i].name && m_tracks[j].index.size()==m_data.positionX(i).size())
+                tracks[i].index=m_tracks[j].index;
+        if(tracks[i].index.size()!=m_data.positionX(i).size())
+            tracks[i].index.build(m_data.positionX(i),m_data.positionZ(i));
+    }
+    m_tracks=tracks;
+}
+
+QPointF TrajectoryView::toScreen(float x, float y) const
+{
+    return QPointF(m_area.left()+(x-m_minX)*m_scale,m_area.bottom()-(y-m_minY)*m_scale);
+}
+
+void TrajectoryView::renderTracks()
+{
+    ensureTracks();
+    m_area=rect().adjusted(10,m_channel->height()+10,-10,-10);
+    m_image=QImage(size(),QImage::Format_RGB32);
+    m_image.fill(Qt::white);
+    bool any=false;
+    float minX=0,minY=0,maxX=0,maxY=0;
+    for(int i=0;i<m_tracks.size();i++)
+    {
+        const SpatialIndex &index=m_tracks[i].index;
+        if(index.size()==0)
+            continue;
+        minX=any ? qMin(minX,index.minX()) : index.minX();
+        minY=any ? qMin(minY,index.minY()) : index.minY();
+        maxX=any ? qMax(maxX,index.maxX()) : index.maxX();
+        maxY=any ? qMax(maxY,index.maxY()) : index.maxY();
+        any=true;
+    }
+    m_dirty=false;
+    if(!any || m_channel->currentIndex()<0)
+        return;
+    m_minX=minX;
+    m_minY=minY;
+    m_scale=qMin(m_area.width()/qMax(1e-6f,maxX-minX),m_area.height()/qMax(1e-6f,maxY-minY));
+
+    QPainter painter(&m_image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    const int channel=m_channel->currentIndex();
+    for(int i=0;i<m_tracks.size();i++)
+    {
+        const QVector<float> &x=m_data.positionX(i);
+        const QVector<float> &y=m_data.positionZ(i);
+        const QVector<float> &values=m_data.column(i,channel);
+        const int step=qMax(1,x.size()*m_tracks.size()/KMaxSegments);
+        //шкала цвета - по рисуемым отсчётам: индекс статистики строится в фоне и может быть не готов
+        float minValue=qInf();
+        float maxValue=-qInf();
+        for(int k=0;k<x.size();k+=step)
+            if(qIsFinite(values[k]))
+            {
+                minValue=qMin(minValue,values[k]);
+                maxValue=qMax(maxValue,values[k]);
+            }
+        const float span=qMax(1e-12f,maxValue-minValue);
+        //отрезки группируются по цвету, чтобы рисовать их пачками
+        QVector<QVector<QLineF> > buckets(KColorBuckets+1);
+        for(int k=step;k<x.size();k+=step)
+        {
+            if(!qIsFinite(x[k]) || !qIsFinite(y[k]) || !qIsFinite(x[k-step]) || !qIsFinite(y[k-step]))
+                continue;
+            int bucket=qIsFinite(values[k]) ? qBound(0,int((values[k]-minValue)/span*(KColorBuckets-1)),KColorBuckets-1) : KColorBuckets;
+            buckets[bucket].append(QLineF(toScreen(x[k-step],y[k-step]),toScreen(x[k],y[k])));
+        }
+        for(int b=0;b<=KColorBuckets;b++)
+        {
+            if(buckets[b].isEmpty())
+                continue;
+            float v=float(b)/(KColorBuckets-1);
+            painter.setPen(QPen(b==KColorBuckets ? QColor(Qt::lightGray) : QColor::fromRgbF(v,0.2,1-v),2));
+            painter.drawLines(buckets[b]);
+        }
+    }
+}
+
+void TrajectoryView::paintEvent(QPaintEvent *)
+{
+    if(m_dirty || m_image.size()!=size())
+        renderTracks();
+    QPainter painter(this);
+    painter.drawImage(0,0,m_image);
+    if(!qIsFinite(m_markerTime))
+        return;
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(Qt::black,2));
+    for(int i=0;i<m_tracks.size() && i<m_data.length();i++)
+    {
+        const QVector<double> &time=m_data.time(i);
+        int k=int(std::upper_bound(time.constBegin(),time.constEnd(),m_markerTime)-time.constBegin())-1;
+        if(k<0 || !qIsFinite(m_data.positionX(i)[k]) || !qIsFinite(m_data.positionZ(i)[k]))
+            continue;
+        painter.drawEllipse(toScreen(m_data.positionX(i)[k],m_data.positionZ(i)[k]),5,5);
+    }
+}
+
+void TrajectoryView::mouseMoveEvent(QMouseEvent *event)
+{
+    if(m_dirty || m_scale<=0)
+        return;
+    const float x=m_minX+(event->pos().x()-m_area.left())/m_scale;
+    const float y=m_minY+(m_area.bottom()-event->pos().y())/m_scale;
+    float radius=KHoverRadius/m_scale;
+    double time=qQNaN();
+    for(int i=0;i<m_tracks.size() && i<m_data.length();i++)
+    {
+        int k=m_tracks[i].index.nearest(x,y,radius);
+        if(k<0)
+            continue;
+        //следующие прогоны ищутся только ближе уже найденной точки
+        float dx=m_data.positionX(i)[k]-x;
+        float dy=m_data.positionZ(i)[k]-y;
+        radius=std::sqrt(dx*dx+dy*dy);
+        time=m_data.time(i)[k];
+    }
+    if(qIsFinite(time))
+    {
+        setMarkerTime(time);
+        emit timeHovered(time);
+    }
+}
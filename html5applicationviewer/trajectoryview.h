@@ -0,0 +1,51 @@
+#ifndef TRAJECTORYVIEW_H
+#define TRAJECTORYVIEW_H
+
+#include <QWidget>
+#include <QComboBox>
+#include <QImage>
+
+#include "graphdata.h"
+#include "spatialindex.h"
+
+//Траектория камеры сверху, раскрашенная по значению выбранного канала.
+//Наведение на трассу сообщает время отсчёта, и наоборот - маркер ставится по времени с графиков
+class TrajectoryView : public QWidget
+{
+    Q_OBJECT
+public:
+    TrajectoryView(GraphData &data,QWidget *parent = 0);
+    void refreshLists(const QStringList &channelNames);
+signals:
+    void timeHovered(double t);
+public slots:
+    void setMarkerTime(double t);
+    void dataChanged();
+private slots:
+    void channelChanged();
+protected:
+    void paintEvent(QPaintEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+    void resizeEvent(QResizeEvent *event);
+private:
+    struct Track
+    {
+        QString name;
+        SpatialIndex index;
+    };
+    GraphData &m_data;
+    QComboBox *m_channel;
+    QVector<Track> m_tracks;
+    QImage m_image;//отрисованные траектории, маркер рисуется поверх
+    bool m_dirty;
+    double m_markerTime;
+    float m_minX;
+    float m_minY;
+    float m_scale;
+    QRect m_area;
+    void ensureTracks();
+    void renderTracks();
+    QPointF toScreen(float x,float y) const;
+};
+
+#endif // TRAJECTORYVIEW_H
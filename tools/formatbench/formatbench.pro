@@ -0,0 +1,17 @@
+# Benchmark for the number-to-text paths used by the JS bridge and CSV export:
+# QString::number per value (the old GraphData::format) against FloatFormat.
+QT += core
+CONFIG += console c++11
+CONFIG -= app_bundle
+TARGET = formatbench
+
+INCLUDEPATH += ../../html5applicationviewer
+SOURCES += main.cpp \
+    ../../html5applicationviewer/floatformat.cpp \
+    ../../html5applicationviewer/graphdata.cpp \
+    ../../html5applicationviewer/channelstatistics.cpp \
+    ../../html5applicationviewer/channelexpression.cpp \
+    ../../html5applicationviewer/lograngereader.cpp \
+    ../../html5applicationviewer/logformat.cpp
+HEADERS += ../../html5applicationviewer/floatformat.h \
+    ../../html5applicationviewer/graphdata.h
@@ -0,0 +1,92 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QVector>
+#include <qnumeric.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#include "graphdata.h"
+#include "floatformat.h"
+
+//GraphData::format до FloatFormat: QString::number на каждое значение
+static QString formatLegacy(const double *t,const float *y,int count)
+{
+    QString result;
+    result.reserve(count*24);
+    for(int i=0;i<count;i++)
+    {
+        if(i)
+            result+=",";
+        result+="["+QString::number(t[i],'f')+","+(qIsFinite(y[i]) ? QString::number(y[i],'f') : QString("null"))+"]";
+    }
+    return result;
+}
+
+//кратчайшая точная запись через snprintf: перебор точности со сверкой strtof
+static int formatSnprintf(float value,char *out)
+{
+    for(int precision=1;precision<9;precision++)
+    {
+        int length=snprintf(out,FloatFormat::KMaxShortestLength+8,"%.*g",precision,value);
+        if(strtof(out,0)==value)
+            return length;
+    }
+    return snprintf(out,FloatFormat::KMaxShortestLength+8,"%.9g",value);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int count=argc>1 ? QString(argv[1]).toInt() : 1000000;
+    QTextStream out(stdout);
+
+    QVector<double> t(count);
+    QVector<float> y(count);
+    for(int i=0;i<count;i++)
+    {
+        t[i]=i*0.001;
+        y[i]=i%1000==0 ? qQNaN() : float(std::sin(i*0.001)*45);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QString legacy=formatLegacy(t.constData(),y.constData(),count);
+    qint64 legacyNs=timer.nsecsElapsed();
+
+    timer.restart();
+    QString fast=GraphData::format(t.constData(),y.constData(),count);
+    qint64 fastNs=timer.nsecsElapsed();
+
+    char buffer[64];
+    qint64 checksum=0;
+    timer.restart();
+    for(int i=0;i<count;i++)
+        checksum+=formatSnprintf(y[i],buffer);
+    qint64 snprintfNs=timer.nsecsElapsed();
+
+    timer.restart();
+    for(int i=0;i<count;i++)
+        checksum+=FloatFormat::shortest(y[i],buffer);
+    qint64 shortestNs=timer.nsecsElapsed();
+
+    //каждое значение должно читаться обратно без потерь
+    int mismatches=0;
+    for(int i=0;i<count;i++)
+    {
+        if(!FloatFormat::isFinite(y[i]))
+            continue;
+        buffer[FloatFormat::shortest(y[i],buffer)]=0;
+        if(strtof(buffer,0)!=y[i])
+            mismatches++;
+    }
+
+    out<<"samples: "<<count<<"\n";
+    out<<"GraphData::format, QString::number: "<<double(legacyNs)/count<<" ns/sample, "<<legacy.size()<<" chars\n";
+    out<<"GraphData::format, FloatFormat:     "<<double(fastNs)/count<<" ns/sample, "<<fast.size()<<" chars\n";
+    out<<"shortest float, snprintf+strtof:    "<<double(snprintfNs)/count<<" ns/value\n";
+    out<<"shortest float, FloatFormat:        "<<double(shortestNs)/count<<" ns/value\n";
+    out<<"round-trip mismatches: "<<mismatches<<" (checksum "<<checksum<<")\n";
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,13 @@
+# Stand-in for the simulator: publishes synthetic records to the viewer's
+# "Live input" socket at a given rate and reports send-side backpressure.
+QT += core gui network
+CONFIG += console c++11
+CONFIG -= app_bundle
+TARGET = livepublisher
+
+INCLUDEPATH += ../../html5applicationviewer
+SOURCES += main.cpp \
+    ../../html5applicationviewer/logformat.cpp
+HEADERS += ../../html5applicationviewer/livestream.h \
+    ../../html5applicationviewer/logformat.h \
+    ../../html5applicationviewer/common.h
@@ -0,0 +1,88 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QLocalSocket>
+#include <QThread>
+#include <QVector>
+#include <cmath>
+
+#include "livestream.h"
+
+static const qint64 KMaxQueued = 4*1024*1024;//байт в очереди сокета, дальше отправитель ждёт
+static const float KStep = 0.001f;//шаг физики синтетического прогона, с
+
+//синтетический заезд: руль догоняет желаемый угол, линия колеблется вокруг центра кадра
+static void makeRecord(qint64 i,DataSet &dataset)
+{
+    dataset=DataSet();
+    const float t=i*KStep;
+    dataset.desired_wheel_angle=20*std::sin(t*0.5f);
+    dataset.current_wheel_angle=20*std::sin(t*0.5f-0.2f);
+    dataset.wheel_power_r=50+10*std::sin(t*0.5f);
+    dataset.wheel_power_l=50-10*std::sin(t*0.5f);
+    dataset.physics_timestep=KStep;
+    dataset.control_interval=0.02f;
+    dataset.line_position=qint32(64+40*std::sin(t*0.7f));
+    for(int p=0;p<CAMERA_FRAME_LEN;p++)
+        dataset.camera_pixels[p]=std::abs(p-dataset.line_position)<3 ? 0 : 200;
+    dataset.camera.p=QVector3D(100*std::cos(t*0.05f),0,100*std::sin(t*0.05f));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QString run=argc>1 ? QString(argv[1]) : QString("sim");
+    int rate=argc>2 ? QString(argv[2]).toInt() : 10000;//записей в секунду
+    int seconds=argc>3 ? QString(argv[3]).toInt() : 30;
+    int batch=argc>4 ? QString(argv[4]).toInt() : 100;//записей в кадре
+    QString server=argc>5 ? QString(argv[5]) : QString(LiveStream::DefaultServerName);
+    QTextStream out(stdout);
+    if(rate<=0 || batch<=0)
+    {
+        out<<"usage: livepublisher [run] [records/s] [seconds] [batch] [server]\n";
+        return 1;
+    }
+
+    QLocalSocket socket;
+    socket.connectToServer(server);
+    if(!socket.waitForConnected())
+    {
+        out<<"cannot connect to "<<server<<": "<<socket.errorString()<<"\n";
+        return 1;
+    }
+    socket.write(LiveStream::hello(run));
+
+    const qint64 total=qint64(rate)*seconds;
+    QVector<DataSet> records(batch);
+    QElapsedTimer timer;
+    QElapsedTimer wait;
+    qint64 blocked=0;
+    qint64 sent=0;
+    timer.start();
+    while(sent<total && socket.state()==QLocalSocket::ConnectedState)
+    {
+        //кадр уходит, когда по расписанию набралась пачка
+        const qint64 remaining=(sent+batch)*1000/rate-timer.elapsed();
+        if(remaining>0)
+            QThread::msleep(remaining);
+        const int count=int(qMin<qint64>(batch,total-sent));
+        for(int i=0;i<count;i++)
+            makeRecord(sent+i,records[i]);
+        socket.write(LiveStream::batch(records.constData(),count));
+        sent+=count;
+        //приёмник не успевает: очередь не растёт, отправитель ждёт
+        wait.start();
+        while(socket.bytesToWrite()>KMaxQueued && socket.waitForBytesWritten(1000))
+            ;
+        socket.waitForBytesWritten(0);
+        blocked+=wait.elapsed();
+    }
+    socket.flush();
+    while(socket.bytesToWrite()>0 && socket.waitForBytesWritten(1000))
+        ;
+    socket.disconnectFromServer();
+    const qint64 elapsed=timer.elapsed();
+    out<<"records: "<<sent<<" in "<<elapsed<<" ms, "<<(elapsed>0 ? sent*1000/elapsed : 0)<<" records/s\n";
+    out<<"waited on backpressure: "<<blocked<<" ms\n";
+    return 0;
+}
@@ -0,0 +1,17 @@
+# Throughput benchmark for Logger: compares the batched writer against
+# the previous per-field QDataStream writer.
+QT += core gui
+CONFIG += console c++11
+CONFIG -= app_bundle
+TARGET = loggerbench
+
+INCLUDEPATH += ../../html5applicationviewer
+SOURCES += main.cpp \
+    ../../html5applicationviewer/logger.cc \
+    ../../html5applicationviewer/logformat.cpp \
+    ../../html5applicationviewer/sharedring.cpp
+HEADERS += ../../html5applicationviewer/logger.h \
+    ../../html5applicationviewer/logformat.h \
+    ../../html5applicationviewer/spscringbuffer.h \
+    ../../html5applicationviewer/sharedring.h \
+    ../../html5applicationviewer/common.h
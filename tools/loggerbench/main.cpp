@@ -0,0 +1,109 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QFileInfo>
+
+#include "logger.h"
+
+//Запись так, как её делал Logger до версии 2: только поля версии 1, по одному вызову QDataStream на поле
+static void writeLegacy(const QString &fileName,const DataSet &dataset,int count)
+{
+    QFile file(fileName);
+    file.open(QIODevice::WriteOnly);
+    QDataStream stream(&file);
+    stream<<quint32(0x1);
+    for(int i=0;i<count;i++)
+    {
+        stream.writeRawData((const char *)dataset.camera_pixels,CAMERA_FRAME_LEN);
+        stream<<dataset.camera.p;
+        stream<<dataset.camera.q;
+        stream<<dataset.control_interval;
+        stream<<dataset.current_wheel_angle;
+        stream<<dataset.desired_wheel_angle;
+        stream<<dataset.physics_timestep;
+        stream<<dataset.wheel_power_l;
+        stream<<dataset.wheel_power_r;
+        stream<<dataset.line_position;
+    }
+    file.close();
+}
+
+static void writeBatched(const QString &fileName,DataSet &dataset,int count)
+{
+    Logger logger;
+    logger.setFileName(fileName);
+    logger.beginWrite();
+    for(int i=0;i<count;i++)
+        logger<<dataset;
+    logger.endWrite();
+}
+
+static Logger::WriteStats writeAsync(const QString &fileName,DataSet &dataset,int count)
+{
+    Logger logger;
+    logger.setFileName(fileName);
+    logger.setWriteMode(Logger::Asynchronous);
+    logger.beginWrite();
+    for(int i=0;i<count;i++)
+        logger<<dataset;
+    return logger.endWrite();
+}
+
+static void readBack(const QString &fileName,int count)
+{
+    Logger logger;
+    DataSet dataset;
+    logger.setFileName(fileName);
+    logger.beginRead();
+    int read=0;
+    while(logger.canRead())
+    {
+        logger>>dataset;
+        read++;
+    }
+    logger.endRead();
+    if(read!=count)
+        qFatal("read %d records, expected %d",read,count);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int count=argc>1 ? QString(argv[1]).toInt() : 200000;
+    QTemporaryDir dir;
+    QTextStream out(stdout);
+
+    DataSet dataset=DataSet();
+    for(int i=0;i<CAMERA_FRAME_LEN;i++)
+        dataset.camera_pixels[i]=quint8(i);
+    dataset.physics_timestep=0.001f;
+    dataset.line_position=64;
+
+    QElapsedTimer timer;
+    timer.start();
+    writeLegacy(dir.path()+"/legacy.dat",dataset,count);
+    qint64 legacy=timer.nsecsElapsed();
+
+    timer.restart();
+    writeBatched(dir.path()+"/batched.dat",dataset,count);
+    qint64 batched=timer.nsecsElapsed();
+
+    timer.restart();
+    Logger::WriteStats stats=writeAsync(dir.path()+"/async.dat",dataset,count);
+    qint64 async=timer.nsecsElapsed();
+
+    timer.restart();
+    readBack(dir.path()+"/batched.dat",count);
+    readBack(dir.path()+"/async.dat",count);
+    qint64 read=timer.nsecsElapsed()/2;
+
+    QFileInfo legacyFile(dir.path()+"/legacy.dat");
+    QFileInfo batchedFile(dir.path()+"/batched.dat");
+    out<<"records: "<<count<<"\n";
+    out<<"v1 per-field QDataStream write: "<<double(legacy)/count<<" ns/record, "<<legacyFile.size()*1e3/legacy<<" MB/s\n";
+    out<<"v2 batched write (full state):  "<<double(batched)/count<<" ns/record, "<<batchedFile.size()*1e3/batched<<" MB/s\n";
+    out<<"v2 async write incl. drain:     "<<double(async)/count<<" ns/record, blocked "<<stats.blocked<<", dropped "<<stats.dropped<<"\n";
+    out<<"v2 batched read:                "<<double(read)/count<<" ns/record\n";
+    return 0;
+}
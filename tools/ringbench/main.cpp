@@ -0,0 +1,123 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+#include <atomic>
+
+#include "sharedring.h"
+#include "livestream.h"
+
+static const int KBatchRecords = 64;
+static const int KLagSampleRecords = 4096;//записей между замерами отставания
+static const int KEncodeRecords = 100000;
+
+//читатель в том же процессе, через отдельное подключение к сегменту, как у просмотрщика
+class RingReader : public QThread
+{
+public:
+    RingReader(const QString &key) : m_key(key), m_records(0), m_sum(0) {}
+    quint64 records() const {return m_records;}
+protected:
+    void run()
+    {
+        SharedRing ring;
+        while(!ring.attach(m_key))
+            QThread::usleep(100);
+        for(;;)
+        {
+            const bool finished=ring.isFinished();
+            const DataSet *records;
+            qint64 sendTime;
+            int count=ring.peek(records,sendTime);
+            if(count==0)
+            {
+                if(finished)
+                    break;
+                QThread::usleep(50);
+                continue;
+            }
+            //поля читаются прямо из слотов, как при дописывании в GraphData
+            for(int i=0;i<count;i++)
+                m_sum+=records[i].current_wheel_angle+records[i].line_position;
+            ring.release(count);
+            m_records+=count;
+        }
+    }
+private:
+    QString m_key;
+    quint64 m_records;
+    double m_sum;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int seconds=argc>1 ? QString(argv[1]).toInt() : 5;
+    int capacity=argc>2 ? QString(argv[2]).toInt() : 1<<16;
+    bool local=argc>3 ? QString(argv[3])!="viewer" : true;//viewer - читает "Live input" просмотрщика
+    QString key=argc>4 ? QString(argv[4]) : QString(LiveStream::DefaultServerName);
+    QTextStream out(stdout);
+
+    QVector<DataSet> batch(KBatchRecords,DataSet());
+    for(int i=0;i<KBatchRecords;i++)
+    {
+        batch[i].physics_timestep=0.001f;
+        batch[i].current_wheel_angle=float(i);
+        batch[i].line_position=64;
+    }
+
+    //для сравнения: во сколько обходится одна запись при передаче через сокет
+    QElapsedTimer timer;
+    timer.start();
+    QVector<DataSet> encode(KEncodeRecords,batch[0]);
+    QByteArray frame=LiveStream::batch(encode.constData(),encode.size());
+    const double encodeNs=double(timer.nsecsElapsed())/KEncodeRecords;
+
+    SharedRing ring;
+    if(!ring.create(key,"ringbench",capacity))
+    {
+        out<<"cannot create shared memory "<<key<<": "<<ring.errorString()<<"\n";
+        return 1;
+    }
+    RingReader reader(key);
+    if(local)
+        reader.start();
+    else
+        out<<"waiting for the viewer: press \"Live input\"\n";
+
+    quint64 pushed=0;
+    quint64 lagSum=0;
+    quint64 lagMax=0;
+    quint64 samples=0;
+    quint64 batches=0;
+    timer.restart();
+    const qint64 duration=qint64(seconds)*1000;
+    while(timer.elapsed()<duration)
+    {
+        pushed+=ring.push(batch.constData(),KBatchRecords);
+        if(++batches%(KLagSampleRecords/KBatchRecords)==0)
+        {
+            const quint64 lag=ring.lag();
+            lagSum+=lag;
+            lagMax=qMax(lagMax,lag);
+            samples++;
+        }
+    }
+    const qint64 elapsed=timer.nsecsElapsed();
+    const quint64 dropped=ring.dropped();
+    const int ringCapacity=ring.capacity();
+    ring.close();
+    if(local)
+        reader.wait();
+
+    const double rate=pushed*1e9/elapsed;
+    out<<"ring capacity: "<<ringCapacity<<" slots of "<<sizeof(DataSet)<<" bytes\n";
+    out<<"pushed: "<<pushed<<" records, "<<rate<<" records/s, "<<double(elapsed)/qMax<quint64>(1,pushed+dropped)<<" ns/record\n";
+    out<<"dropped (reader behind by a full ring): "<<dropped<<"\n";
+    out<<"reader lag: mean "<<(samples ? double(lagSum)/samples : 0)<<" records, max "<<lagMax<<" records ("<<(rate>0 ? lagMax*1e3/rate : 0)<<" ms)\n";
+    if(local)
+        out<<"read: "<<reader.records()<<" records\n";
+    out<<"socket frame encoding for comparison: "<<encodeNs<<" ns/record ("<<frame.size()/KEncodeRecords<<" bytes)\n";
+    return 0;
+}
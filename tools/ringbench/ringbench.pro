@@ -0,0 +1,15 @@
+# Producer benchmark for the shared-memory live transport: pushes records
+# into a SharedRing as fast as possible and reports records/s and reader lag,
+# with either an in-process reader or the viewer's "Live input" as consumer.
+QT += core gui
+CONFIG += console c++11
+CONFIG -= app_bundle
+TARGET = ringbench
+
+INCLUDEPATH += ../../html5applicationviewer
+SOURCES += main.cpp \
+    ../../html5applicationviewer/sharedring.cpp \
+    ../../html5applicationviewer/logformat.cpp
+HEADERS += ../../html5applicationviewer/sharedring.h \
+    ../../html5applicationviewer/livestream.h \
+    ../../html5applicationviewer/common.h